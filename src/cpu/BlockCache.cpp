@@ -0,0 +1,120 @@
+#include "BlockCache.h"
+#include "../memory/Memory.h"
+
+namespace nescore
+{
+
+const bool BlockCache::ENDS_BLOCK[0x100] = {
+    true, false, true, true, false, false, false, false, false, false, false, false, false, false, true, true,    // 0_
+    true, false, true, true, false, false, false, false, false, false, false, true, false, false, true, true,    // 1_
+    true, false, true, true, false, false, false, false, true, false, false, false, false, false, true, true,    // 2_
+    true, false, true, true, false, false, false, false, false, false, false, true, false, false, true, true,    // 3_
+    true, false, true, true, false, false, false, false, false, false, false, false, true, false, true, true,    // 4_
+    true, false, true, true, false, false, false, false, true, false, false, true, false, false, true, true,    // 5_
+    true, false, true, true, false, false, false, false, false, false, false, false, true, false, true, true,    // 6_
+    true, false, true, true, false, false, false, false, true, false, false, true, false, false, true, true,    // 7_
+    false, true, false, true, false, false, false, false, false, false, false, false, true, true, true, true,    // 8_
+    true, true, true, true, false, false, false, false, false, true, false, true, true, true, true, true,    // 9_
+    false, false, false, false, false, false, false, false, false, false, false, false, false, false, false, false,    // A_
+    true, false, true, false, false, false, false, false, false, false, false, true, false, false, false, false,    // B_
+    false, false, false, true, false, false, false, false, false, false, false, false, false, false, true, true,    // C_
+    true, false, true, true, false, false, false, false, false, false, false, true, false, false, true, true,    // D_
+    false, false, false, true, false, false, false, false, false, false, false, false, false, false, true, true,    // E_
+    true, false, true, true, false, false, false, false, false, false, false, true, false, false, true, true,    // F_
+};
+
+BlockCache::BlockCache()
+    : _blocks(CACHE_SIZE)
+{
+    invalidate();
+}
+
+const BlockCache::Block* BlockCache::find(uint16_t address, const Memory& memory)
+{
+    auto& block = _blocks[(address ^ (address >> 9)) % CACHE_SIZE];
+    if (!isValid(block, address, memory))
+    {
+        decode(block, address, memory);
+    }
+
+    if (block.length == 0)
+    {
+        return nullptr;
+    }
+
+    return &block;
+}
+
+void BlockCache::invalidate()
+{
+    for (auto& block : _blocks)
+    {
+        block.start = 0;
+        block.end = 0;
+        block.length = 0;
+        block.pages[0] = block.pages[1] = nullptr;
+    }
+}
+
+bool BlockCache::isValid(const BlockCache::Block& block, uint16_t address, const Memory& memory) const
+{
+    if (block.start != address || block.pages[0] != memory.getReadOnlyPage(address))
+    {
+        return false;
+    }
+
+    return block.length == 0 || block.pages[1] == memory.getReadOnlyPage(block.end - 1);
+}
+
+void BlockCache::decode(BlockCache::Block& block, uint16_t address, const Memory& memory)
+{
+    block.start = address;
+    block.end = address;
+    block.length = 0;
+    block.maxCycles = 0;
+    block.pages[0] = memory.getReadOnlyPage(address);
+    block.pages[1] = block.pages[0];
+
+    if (!block.pages[0])
+    {
+        return;
+    }
+
+    // Stay within the first page and the one after it, as long as both are read-only
+    uint32_t lastPage = (address >> Memory::PAGE_SHIFT) + 1;
+    auto nextPage = memory.getReadOnlyPage(static_cast<uint16_t>(lastPage << Memory::PAGE_SHIFT));
+
+    uint32_t pc = address;
+    while (block.length < MAX_BLOCK_LENGTH)
+    {
+        uint8_t opcode = memory.readByte(pc);
+        uint8_t length = CPU::OPCODES[opcode].length;
+        uint32_t last = pc + length - 1;
+        if (last > 0xFFFF || (last >> Memory::PAGE_SHIFT) > lastPage || ((last >> Memory::PAGE_SHIFT) == lastPage && !nextPage))
+        {
+            break;
+        }
+
+        auto& entry = CPU::OPCODES[opcode];
+        auto& instruction = block.instructions[block.length++];
+        instruction.handler = entry.handler;
+        instruction.opcode = opcode;
+        instruction.length = length;
+        instruction.maxCycles = entry.cycles + (entry.mode == CPU::Relative ? 2 : entry.pageCrossPenalty ? 1 : 0);
+        instruction.operand[0] = length > 1 ? memory.readByte(pc + 1) : 0;
+        instruction.operand[1] = length > 2 ? memory.readByte(pc + 2) : 0;
+
+        block.maxCycles += instruction.maxCycles;
+        block.pages[1] = memory.getReadOnlyPage(last);
+        pc += length;
+
+        if (ENDS_BLOCK[opcode])
+        {
+            break;
+        }
+    }
+
+    block.end = pc;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef NESCORE_BLOCKCACHE_H
+#define NESCORE_BLOCKCACHE_H
+
+#include <vector>
+#include "CPU.h"
+
+namespace nescore
+{
+
+class Memory;
+
+// Caches pre-decoded runs of instructions from read-only memory (PRG ROM). A block ends at the first
+// instruction that can change control flow, the I flag, or write outside of RAM, so everything in between
+// can be executed without fetching opcodes or checking for events. Blocks remember which host pages they
+// were decoded from and are dropped as soon as a different bank is mapped at their address.
+class BlockCache
+{
+public:
+    static const uint16_t MAX_BLOCK_LENGTH = 16;
+    static const uint16_t CACHE_SIZE = 512;
+
+    // handler is the OPCODES entry and operand is handed to it, so running an instruction fetches neither
+    // the opcode nor its operand bytes again.
+    // maxCycles is the most it can take: the base cycles plus a page crossing, or a taken branch across pages.
+    struct Instruction
+    {
+        CPU::InstructionHandler handler;
+        uint8_t opcode;
+        uint8_t length;
+        uint8_t maxCycles;
+        uint8_t operand[2];
+    };
+
+    struct Block
+    {
+        uint16_t start;
+        uint16_t end;
+        const uint8_t* pages[2];
+        uint8_t length;
+        cpu_cycle_t maxCycles;
+        Instruction instructions[MAX_BLOCK_LENGTH];
+    };
+
+public:
+    BlockCache();
+
+    const Block* find(uint16_t address, const Memory& memory);
+    void invalidate();
+
+private:
+    bool isValid(const Block& block, uint16_t address, const Memory& memory) const;
+    void decode(Block& block, uint16_t address, const Memory& memory);
+
+private:
+    static const bool ENDS_BLOCK[0x100];
+
+    std::vector<Block> _blocks;
+};
+
+}
+
+#endif //NESCORE_BLOCKCACHE_H
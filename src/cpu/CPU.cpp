@@ -4,6 +4,8 @@
 #include <functional>
 #include "CPU.h"
 #include "CPUMemory.h"
+#include "BlockCache.h"
+#include "../scheduler/Scheduler.h"
 
 #include "access/ABS.h"
 #include "access/ABSX.h"
@@ -16,6 +18,7 @@
 #include "access/ZP.h"
 #include "access/ZPX.h"
 #include "access/ZPY.h"
+#include "access/Operand.h"
 
 namespace nescore
 {
@@ -46,12 +49,34 @@ bool CPU::Registers::getFlag(nescore::CPU::Registers::Flags flag) const
 
 
 CPU::CPU()
-    : _memory(std::make_shared<CPUMemory>())
+    : CPU(std::make_shared<CPUMemory>())
+{
+}
+
+CPU::CPU(std::shared_ptr<CPUMemory> memory)
+    : _memory(memory)
+    , _scheduler(std::make_shared<Scheduler>())
     , _cycle(0)
     , _dmaCycle(0)
+    , _dispatchMode(DispatchMode::Switch)
+    , _killed(false)
+    , _stopped(false)
+    , _irq(false)
+    , _lazyFlags(false)
+    , _lazyPending(false)
+    , _lazyResult(0)
+    , _cachedOperand(nullptr)
+    , _idleLoopSkip(false)
+    , _idleLoopCandidate(false)
 {
    _registers.reset();
-    setupInstructions();
+    _memory->setClock(&_cycle);
+    setupEvents();
+}
+
+CPU::~CPU()
+{
+    _memory->setClock(nullptr);
 }
 
 CPU::CPU(const std::vector<uint8_t>& operations)
@@ -65,6 +90,7 @@ CPU::CPU(const std::vector<uint8_t>& operations)
 void CPU::reset()
 {
     _killed = false;
+    _lazyPending = false;
     _registers.reset();
     _registers.PC = _memory->readShort(CPUMemory::RESET_VECTOR);
 }
@@ -76,357 +102,310 @@ void CPU::tick()
         return;
     }
 
-    if (_dmaCycle > 0)
+    step();
+}
+
+void CPU::tick(int count)
+{
+    for (int i = 0; i < count && !_killed; ++i)
     {
-        _dmaCycle--;
-        return;
+        step();
+    }
+}
+
+cpu_cycle_t CPU::runFor(cpu_cycle_t budget)
+{
+    auto end = _cycle + budget;
+    _stopped = false;
+    while (_cycle < end && !_killed && !_stopped)
+    {
+        if (_idleLoopCandidate)
+        {
+            _idleLoopCandidate = false;
+            if (skipIdleLoop(end))
+            {
+                continue;
+            }
+        }
+
+        if (!_blockCache || !runBlock(end))
+        {
+            step();
+        }
+    }
+
+    return _cycle > end ? _cycle - end : 0;
+}
+
+void CPU::stop()
+{
+    _stopped = true;
+}
+
+void CPU::step()
+{
+    while (_cycle >= _scheduler->getNextDeadline())
+    {
+        _scheduler->runNext();
     }
 
     auto opcode = _memory->readByte(_registers.PC++);
-    auto handler = _instructions[opcode];
-    if (!handler)
+    auto cycles = _dispatchMode == DispatchMode::Switch ? execute(opcode) : dispatch(opcode);
+    _cycle += cycles + 1;
+}
+
+bool CPU::runBlock(cpu_cycle_t limit)
+{
+    auto block = _blockCache->find(_registers.PC, *_memory);
+    if (!block || _cycle + block->maxCycles > std::min(limit, _scheduler->getNextDeadline()))
     {
-        throw std::runtime_error("Invalid opcode: " + opcode);
+        return false;
     }
 
-    _cycle++;
-    _cycle += (this->*handler)();
+    for (int i = 0; i < block->length; ++i)
+    {
+        auto& instruction = block->instructions[i];
+        _registers.PC++;
+        _cachedOperand = instruction.operand;
+
+        auto cycles = _dispatchMode == DispatchMode::Switch ? execute(instruction.opcode)
+                                                            : (this->*instruction.handler)();
+        _cycle += cycles + 1;
+    }
+
+    _cachedOperand = nullptr;
+    return true;
 }
 
-void CPU::tick(int count)
+// Recognizes a load or BIT from plain memory followed by a branch back to it. Nothing in such a loop
+// can change the value it polls, so every iteration up to the next event or the limit is the same and
+// they are all accounted for at once. Branch cycles are counted the same way branchOnFlag does.
+bool CPU::skipIdleLoop(cpu_cycle_t limit)
 {
-    for (int i = 0; i < count; ++i)
+    auto pc = _registers.PC;
+    auto opcode = _memory->readByte(pc);
+    switch (opcode)
+    {
+        case 0xA5: case 0xAD:   // LDA
+        case 0xA6: case 0xAE:   // LDX
+        case 0xA4: case 0xAC:   // LDY
+        case 0x24: case 0x2C:   // BIT
+            break;
+
+        default:
+            return false;
+    }
+
+    auto& load = OPCODES[opcode];
+    uint16_t address = load.length == 3 ? _memory->readShort(pc + 1) : _memory->readByte(pc + 1);
+    uint16_t branch = pc + load.length;
+    auto branchOpcode = _memory->readByte(branch);
+    auto offset = static_cast<int8_t>(_memory->readByte(branch + 1));
+    if (OPCODES[branchOpcode].mode != Relative || offset != -(load.length + 2) || !_memory->isDirect(address))
     {
-        tick();
+        return false;
     }
+
+    // Only skip once the loop has settled: another iteration must leave the registers and flags as they are
+    // and take the branch again. An event may have changed the polled value since the last load.
+    uint8_t value = _memory->readByte(address);
+    bool n = value & 0x80;
+    bool v = getFlag(Registers::Flags::V);
+    bool z = value == 0;
+    switch (opcode)
+    {
+        case 0xA5: case 0xAD: if (_registers.A != value) return false; break;
+        case 0xA6: case 0xAE: if (_registers.X != value) return false; break;
+        case 0xA4: case 0xAC: if (_registers.Y != value) return false; break;
+        default: v = value & 0x40; z = (_registers.A & value) == 0; break;
+    }
+    if (getFlag(Registers::Flags::N) != n || getFlag(Registers::Flags::V) != v || getFlag(Registers::Flags::Z) != z)
+    {
+        return false;
+    }
+
+    // Branch opcodes encode the tested flag in bits 6-7 (N, V, C, Z) and the state it has to be in in bit 5
+    static const Registers::Flags BRANCH_FLAGS[] = {
+        Registers::Flags::N, Registers::Flags::V, Registers::Flags::C, Registers::Flags::Z
+    };
+    if (getFlag(BRANCH_FLAGS[branchOpcode >> 6]) != static_cast<bool>(branchOpcode & 0x20))
+    {
+        return false;
+    }
+
+    cpu_cycle_t iteration = load.cycles + 1 + (((branch + 2) & 0xFF00) == (pc & 0xFF00) ? 1 : 2);
+    auto deadline = std::min(limit, _scheduler->getNextDeadline());
+    if (_cycle >= deadline)
+    {
+        return false;
+    }
+
+    auto iterations = (deadline - _cycle) / iteration;
+    _cycle += iterations * iteration;
+    return iterations > 0;
 }
 
 void CPU::startDmaTransfer()
 {
+    // The CPU is halted at the next instruction boundary and skips the whole transfer at once
     _dmaCycle = _cycle % 2 == 0 ? 513 : 514;
+    _scheduler->schedule(Scheduler::DmaTransfer, _cycle);
+}
+
+void CPU::nmi()
+{
+    _scheduler->schedule(Scheduler::Nmi, _cycle);
+}
+
+void CPU::setIrq(bool active)
+{
+    _irq = active;
+    if (active)
+    {
+        _scheduler->schedule(Scheduler::Irq, _cycle);
+    }
+    else
+    {
+        _scheduler->cancel(Scheduler::Irq);
+    }
+}
+
+void CPU::setupEvents()
+{
+    _scheduler->setHandler(Scheduler::DmaTransfer, [this](cpu_cycle_t)
+    {
+        _cycle += _dmaCycle;
+    });
+
+    _scheduler->setHandler(Scheduler::Nmi, [this](cpu_cycle_t)
+    {
+        interrupt(CPUMemory::NMI_VECTOR);
+    });
+
+    _scheduler->setHandler(Scheduler::Irq, [this](cpu_cycle_t)
+    {
+        if (_irq && !_registers.getFlag(Registers::Flags::I))
+        {
+            interrupt(CPUMemory::IRQ_VECTOR);
+        }
+    });
+}
+
+void CPU::interrupt(uint16_t vector)
+{
+    resolveFlags();
+    _memory->pushShort(_registers.S, _registers.PC);
+    _memory->pushByte(_registers.S, (_registers.P & ~Registers::Flags::B) | Registers::Flags::L);
+    _registers.setFlag(Registers::Flags::I, true);
+    _registers.PC = _memory->readShort(vector);
+    _cycle += 7;
+}
+
+void CPU::pollIrq()
+{
+    // IRQ is level triggered, so it has to be taken again once the I flag is cleared
+    if (_irq && !_registers.getFlag(Registers::Flags::I))
+    {
+        _scheduler->schedule(Scheduler::Irq, _cycle);
+    }
+}
+
+void CPU::setDispatchMode(CPU::DispatchMode mode)
+{
+    _dispatchMode = mode;
+}
+
+CPU::DispatchMode CPU::getDispatchMode() const
+{
+    return _dispatchMode;
+}
+
+void CPU::setBlockCacheEnabled(bool enabled)
+{
+    if (enabled && !_blockCache)
+    {
+        _blockCache.reset(new BlockCache());
+    }
+    else if (!enabled)
+    {
+        _blockCache.reset();
+    }
+}
+
+bool CPU::isBlockCacheEnabled() const
+{
+    return _blockCache != nullptr;
+}
+
+// With lazy flags, references returned by getRegisters() only see N and Z as of the last call
+void CPU::setLazyFlagsEnabled(bool enabled)
+{
+    resolveFlags();
+    _lazyFlags = enabled;
+}
+
+bool CPU::isLazyFlagsEnabled() const
+{
+    return _lazyFlags;
+}
+
+void CPU::setIdleLoopSkipEnabled(bool enabled)
+{
+    _idleLoopSkip = enabled;
+    _idleLoopCandidate = false;
+}
+
+bool CPU::isIdleLoopSkipEnabled() const
+{
+    return _idleLoopSkip;
 }
 
 CPU::Registers &CPU::getRegisters()
 {
+    resolveFlags();
     return _registers;
 }
 
+// A copy with any pending N and Z flags applied. The CPU itself is left untouched, so const readers don't race
+CPU::Registers CPU::getRegisters() const
+{
+    Registers registers = _registers;
+    if (_lazyPending)
+    {
+        registers.setFlag(Registers::Flags::Z, _lazyResult == 0);
+        registers.setFlag(Registers::Flags::N, _lazyResult & 0x80);
+    }
+
+    return registers;
+}
+
 std::shared_ptr<CPUMemory> CPU::getMemory()
 {
     return _memory;
 }
 
+std::shared_ptr<Scheduler> CPU::getScheduler()
+{
+    return _scheduler;
+}
+
 cpu_cycle_t CPU::getCycle() const
 {
     return _cycle;
 }
 
-void CPU::setupInstructions()
-{
-    memset(&_instructions, 0, sizeof(InstructionHandler) * 0x100);
-
-    _instructions[0x69] = &CPU::op_adc<IMM>;
-    _instructions[0x65] = &CPU::op_adc<ZP>;
-    _instructions[0x75] = &CPU::op_adc<ZPX>;
-    _instructions[0x6D] = &CPU::op_adc<ABS>;
-    _instructions[0x7D] = &CPU::op_adc<ABSX>;
-    _instructions[0x79] = &CPU::op_adc<ABSY>;
-    _instructions[0x61] = &CPU::op_adc<INDX>;
-    _instructions[0x71] = &CPU::op_adc<INDY>;
-    
-    _instructions[0x29] = &CPU::op_and<IMM>;
-    _instructions[0x25] = &CPU::op_and<ZP>;
-    _instructions[0x35] = &CPU::op_and<ZPX>;
-    _instructions[0x2D] = &CPU::op_and<ABS>;
-    _instructions[0x3D] = &CPU::op_and<ABSX>;
-    _instructions[0x39] = &CPU::op_and<ABSY>;
-    _instructions[0x21] = &CPU::op_and<INDX>;
-    _instructions[0x31] = &CPU::op_and<INDY>;
-
-    _instructions[0x0A] = &CPU::op_asl<ACC>;
-    _instructions[0x06] = &CPU::op_asl<ZP>;
-    _instructions[0x16] = &CPU::op_asl<ZPX>;
-    _instructions[0x0E] = &CPU::op_asl<ABS>;
-    _instructions[0x1E] = &CPU::op_asl<ABSX>;
-
-    _instructions[0x90] = &CPU::op_bcc;
-    _instructions[0xB0] = &CPU::op_bcs;
-    _instructions[0xF0] = &CPU::op_beq;
-    _instructions[0x30] = &CPU::op_bmi;
-    _instructions[0xD0] = &CPU::op_bne;
-    _instructions[0x10] = &CPU::op_bpl;
-    _instructions[0x50] = &CPU::op_bvc;
-    _instructions[0x70] = &CPU::op_bvs;
-
-    _instructions[0x24] = &CPU::op_bit<ZP>;
-    _instructions[0x2C] = &CPU::op_bit<ABS>;
-
-    _instructions[0x00] = &CPU::op_brk;
-
-    _instructions[0x18] = &CPU::op_clc;
-    _instructions[0xD8] = &CPU::op_cld;
-    _instructions[0x58] = &CPU::op_cli;
-    _instructions[0xB8] = &CPU::op_clv;
-
-    _instructions[0xC9] = &CPU::op_cmp<IMM>;
-    _instructions[0xC5] = &CPU::op_cmp<ZP>;
-    _instructions[0xD5] = &CPU::op_cmp<ZPX>;
-    _instructions[0xCD] = &CPU::op_cmp<ABS>;
-    _instructions[0xDD] = &CPU::op_cmp<ABSX>;
-    _instructions[0xD9] = &CPU::op_cmp<ABSY>;
-    _instructions[0xC1] = &CPU::op_cmp<INDX>;
-    _instructions[0xD1] = &CPU::op_cmp<INDY>;
-
-    _instructions[0xE0] = &CPU::op_cpx<IMM>;
-    _instructions[0xE4] = &CPU::op_cpx<ZP>;
-    _instructions[0xEC] = &CPU::op_cpx<ABS>;
-    _instructions[0xC0] = &CPU::op_cpy<IMM>;
-    _instructions[0xC4] = &CPU::op_cpy<ZP>;
-    _instructions[0xCC] = &CPU::op_cpy<ABS>;
-
-    _instructions[0xC6] = &CPU::op_dec<ZP>;
-    _instructions[0xD6] = &CPU::op_dec<ZPX>;
-    _instructions[0xCE] = &CPU::op_dec<ABS>;
-    _instructions[0xDE] = &CPU::op_dec<ABSX>;
-    _instructions[0xCA] = &CPU::op_dex;
-    _instructions[0x88] = &CPU::op_dey;
-
-    _instructions[0x49] = &CPU::op_eor<IMM>;
-    _instructions[0x45] = &CPU::op_eor<ZP>;
-    _instructions[0x55] = &CPU::op_eor<ZPX>;
-    _instructions[0x4D] = &CPU::op_eor<ABS>;
-    _instructions[0x5D] = &CPU::op_eor<ABSX>;
-    _instructions[0x59] = &CPU::op_eor<ABSY>;
-    _instructions[0x41] = &CPU::op_eor<INDX>;
-    _instructions[0x51] = &CPU::op_eor<INDY>;
-
-    _instructions[0xE6] = &CPU::op_inc<ZP>;
-    _instructions[0xF6] = &CPU::op_inc<ZPX>;
-    _instructions[0xEE] = &CPU::op_inc<ABS>;
-    _instructions[0xFE] = &CPU::op_inc<ABSX>;
-    _instructions[0xE8] = &CPU::op_inx;
-    _instructions[0xC8] = &CPU::op_iny;
-
-    _instructions[0x4C] = &CPU::op_jmp_abs;
-    _instructions[0x6C] = &CPU::op_jmp_ind;
-    _instructions[0x20] = &CPU::op_jsr;
-
-    _instructions[0xA9] = &CPU::op_lda<IMM>;
-    _instructions[0xA5] = &CPU::op_lda<ZP>;
-    _instructions[0xB5] = &CPU::op_lda<ZPX>;
-    _instructions[0xAD] = &CPU::op_lda<ABS>;
-    _instructions[0xBD] = &CPU::op_lda<ABSX>;
-    _instructions[0xB9] = &CPU::op_lda<ABSY>;
-    _instructions[0xA1] = &CPU::op_lda<INDX>;
-    _instructions[0xB1] = &CPU::op_lda<INDY>;
-    _instructions[0xA2] = &CPU::op_ldx<IMM>;
-    _instructions[0xA6] = &CPU::op_ldx<ZP>;
-    _instructions[0xB6] = &CPU::op_ldx<ZPY>;
-    _instructions[0xAE] = &CPU::op_ldx<ABS>;
-    _instructions[0xBE] = &CPU::op_ldx<ABSY>;
-    _instructions[0xA0] = &CPU::op_ldy<IMM>;
-    _instructions[0xA4] = &CPU::op_ldy<ZP>;
-    _instructions[0xB4] = &CPU::op_ldy<ZPX>;
-    _instructions[0xAC] = &CPU::op_ldy<ABS>;
-    _instructions[0xBC] = &CPU::op_ldy<ABSX>;
-
-    _instructions[0x4A] = &CPU::op_lsr<ACC>;
-    _instructions[0x46] = &CPU::op_lsr<ZP>;
-    _instructions[0x56] = &CPU::op_lsr<ZPX>;
-    _instructions[0x4E] = &CPU::op_lsr<ABS>;
-    _instructions[0x5E] = &CPU::op_lsr<ABSX>;
-
-    _instructions[0xEA] = &CPU::op_nop;
-
-    _instructions[0x09] = &CPU::op_ora<IMM>;
-    _instructions[0x05] = &CPU::op_ora<ZP>;
-    _instructions[0x15] = &CPU::op_ora<ZPX>;
-    _instructions[0x0D] = &CPU::op_ora<ABS>;
-    _instructions[0x1D] = &CPU::op_ora<ABSX>;
-    _instructions[0x19] = &CPU::op_ora<ABSY>;
-    _instructions[0x01] = &CPU::op_ora<INDX>;
-    _instructions[0x11] = &CPU::op_ora<INDY>;
-
-    _instructions[0x48] = &CPU::op_pha;
-    _instructions[0x08] = &CPU::op_php;
-    _instructions[0x68] = &CPU::op_pla;
-    _instructions[0x28] = &CPU::op_plp;
-
-    _instructions[0x2A] = &CPU::op_rol<ACC>;
-    _instructions[0x26] = &CPU::op_rol<ZP>;
-    _instructions[0x36] = &CPU::op_rol<ZPX>;
-    _instructions[0x2E] = &CPU::op_rol<ABS>;
-    _instructions[0x3E] = &CPU::op_rol<ABSX>;
-    _instructions[0x6A] = &CPU::op_ror<ACC>;
-    _instructions[0x66] = &CPU::op_ror<ZP>;
-    _instructions[0x76] = &CPU::op_ror<ZPX>;
-    _instructions[0x6E] = &CPU::op_ror<ABS>;
-    _instructions[0x7E] = &CPU::op_ror<ABSX>;
-
-    _instructions[0x40] = &CPU::op_rti;
-    _instructions[0x60] = &CPU::op_rts;
-
-    _instructions[0xE9] = &CPU::op_sbc<IMM>;
-    _instructions[0xEB] = &CPU::op_sbc<IMM>;
-    _instructions[0xE5] = &CPU::op_sbc<ZP>;
-    _instructions[0xF5] = &CPU::op_sbc<ZPX>;
-    _instructions[0xED] = &CPU::op_sbc<ABS>;
-    _instructions[0xFD] = &CPU::op_sbc<ABSX>;
-    _instructions[0xF9] = &CPU::op_sbc<ABSY>;
-    _instructions[0xE1] = &CPU::op_sbc<INDX>;
-    _instructions[0xF1] = &CPU::op_sbc<INDY>;
-
-    _instructions[0x38] = &CPU::op_sec;
-    _instructions[0xF8] = &CPU::op_sed;
-    _instructions[0x78] = &CPU::op_sei;
-
-    _instructions[0x85] = &CPU::op_sta<ZP>;
-    _instructions[0x95] = &CPU::op_sta<ZPX>;
-    _instructions[0x8D] = &CPU::op_sta<ABS>;
-    _instructions[0x9D] = &CPU::op_sta<ABSX>;
-    _instructions[0x99] = &CPU::op_sta<ABSY>;
-    _instructions[0x81] = &CPU::op_sta<INDX>;
-    _instructions[0x91] = &CPU::op_sta<INDY>;
-    _instructions[0x86] = &CPU::op_stx<ZP>;
-    _instructions[0x96] = &CPU::op_stx<ZPY>;
-    _instructions[0x8E] = &CPU::op_stx<ABS>;
-    _instructions[0x84] = &CPU::op_sty<ZP>;
-    _instructions[0x94] = &CPU::op_sty<ZPX>;
-    _instructions[0x8C] = &CPU::op_sty<ABS>;
-
-    _instructions[0xAA] = &CPU::op_tax;
-    _instructions[0xA8] = &CPU::op_tay;
-    _instructions[0xBA] = &CPU::op_tsx;
-    _instructions[0x8A] = &CPU::op_txa;
-    _instructions[0x9A] = &CPU::op_txs;
-    _instructions[0x98] = &CPU::op_tya;
-
-    _instructions[0x4B] = &CPU::op_alr;
-    _instructions[0x0B] = &CPU::op_anc;
-    _instructions[0x2B] = &CPU::op_anc;
-    _instructions[0x6B] = &CPU::op_arr;
-    _instructions[0xCB] = &CPU::op_axs;
-
-    _instructions[0xAB] = &CPU::op_lax<IMM>;
-    _instructions[0xA7] = &CPU::op_lax<ZP>;
-    _instructions[0xB7] = &CPU::op_lax<ZPY>;
-    _instructions[0xAF] = &CPU::op_lax<ABS>;
-    _instructions[0xBF] = &CPU::op_lax<ABSY>;
-    _instructions[0xA3] = &CPU::op_lax<INDX>;
-    _instructions[0xB3] = &CPU::op_lax<INDY>;
-
-    _instructions[0x87] = &CPU::op_sax<ZP>;
-    _instructions[0x97] = &CPU::op_sax<ZPY>;
-    _instructions[0x83] = &CPU::op_sax<INDX>;
-    _instructions[0x8F] = &CPU::op_sax<ABS>;
-
-    _instructions[0xC7] = &CPU::op_dcp<ZP>;
-    _instructions[0xD7] = &CPU::op_dcp<ZPX>;
-    _instructions[0xCF] = &CPU::op_dcp<ABS>;
-    _instructions[0xDF] = &CPU::op_dcp<ABSX>;
-    _instructions[0xDB] = &CPU::op_dcp<ABSY>;
-    _instructions[0xC3] = &CPU::op_dcp<INDX>;
-    _instructions[0xD3] = &CPU::op_dcp<INDY>;
-
-    _instructions[0xE7] = &CPU::op_isc<ZP>;
-    _instructions[0xF7] = &CPU::op_isc<ZPX>;
-    _instructions[0xEF] = &CPU::op_isc<ABS>;
-    _instructions[0xFF] = &CPU::op_isc<ABSX>;
-    _instructions[0xFB] = &CPU::op_isc<ABSY>;
-    _instructions[0xE3] = &CPU::op_isc<INDX>;
-    _instructions[0xF3] = &CPU::op_isc<INDY>;
-
-    _instructions[0x27] = &CPU::op_rla<ZP>;
-    _instructions[0x37] = &CPU::op_rla<ZPX>;
-    _instructions[0x2F] = &CPU::op_rla<ABS>;
-    _instructions[0x3F] = &CPU::op_rla<ABSX>;
-    _instructions[0x3B] = &CPU::op_rla<ABSY>;
-    _instructions[0x23] = &CPU::op_rla<INDX>;
-    _instructions[0x33] = &CPU::op_rla<INDY>;
-
-    _instructions[0x67] = &CPU::op_rra<ZP>;
-    _instructions[0x77] = &CPU::op_rra<ZPX>;
-    _instructions[0x6F] = &CPU::op_rra<ABS>;
-    _instructions[0x7F] = &CPU::op_rra<ABSX>;
-    _instructions[0x7B] = &CPU::op_rra<ABSY>;
-    _instructions[0x63] = &CPU::op_rra<INDX>;
-    _instructions[0x73] = &CPU::op_rra<INDY>;
-
-    _instructions[0x07] = &CPU::op_slo<ZP>;
-    _instructions[0x17] = &CPU::op_slo<ZPX>;
-    _instructions[0x0F] = &CPU::op_slo<ABS>;
-    _instructions[0x1F] = &CPU::op_slo<ABSX>;
-    _instructions[0x1B] = &CPU::op_slo<ABSY>;
-    _instructions[0x03] = &CPU::op_slo<INDX>;
-    _instructions[0x13] = &CPU::op_slo<INDY>;
-
-    _instructions[0x47] = &CPU::op_sre<ZP>;
-    _instructions[0x57] = &CPU::op_sre<ZPX>;
-    _instructions[0x4F] = &CPU::op_sre<ABS>;
-    _instructions[0x5F] = &CPU::op_sre<ABSX>;
-    _instructions[0x5B] = &CPU::op_sre<ABSY>;
-    _instructions[0x43] = &CPU::op_sre<INDX>;
-    _instructions[0x53] = &CPU::op_sre<INDY>;
-
-    _instructions[0xEB] = &CPU::op_sbc<IMM>;
-
-    _instructions[0x1A] = &CPU::op_nop;
-    _instructions[0x3A] = &CPU::op_nop;
-    _instructions[0x5A] = &CPU::op_nop;
-    _instructions[0x7A] = &CPU::op_nop;
-    _instructions[0xDA] = &CPU::op_nop;
-    _instructions[0xFA] = &CPU::op_nop;
-
-    _instructions[0x04] = &CPU::op_skb<ZP>;
-    _instructions[0x14] = &CPU::op_skb<ZPX>;
-    _instructions[0x34] = &CPU::op_skb<ZPX>;
-    _instructions[0x44] = &CPU::op_skb<ZP>;
-    _instructions[0x54] = &CPU::op_skb<ZPX>;
-    _instructions[0x64] = &CPU::op_skb<ZP>;
-    _instructions[0x74] = &CPU::op_skb<ZPX>;
-    _instructions[0x80] = &CPU::op_skb<IMM>;
-    _instructions[0x82] = &CPU::op_skb<IMM>;
-    _instructions[0x89] = &CPU::op_skb<IMM>;
-    _instructions[0xC2] = &CPU::op_skb<IMM>;
-    _instructions[0xD4] = &CPU::op_skb<ZPX>;
-    _instructions[0xE2] = &CPU::op_skb<IMM>;
-    _instructions[0xF4] = &CPU::op_skb<ZPX>;
-
-    _instructions[0x0C] = &CPU::op_ign<ABS>;
-    _instructions[0x1C] = &CPU::op_ign<ABSX>;
-    _instructions[0x3C] = &CPU::op_ign<ABSX>;
-    _instructions[0x5C] = &CPU::op_ign<ABSX>;
-    _instructions[0x7C] = &CPU::op_ign<ABSX>;
-    _instructions[0xDC] = &CPU::op_ign<ABSX>;
-    _instructions[0xFC] = &CPU::op_ign<ABSX>;
-
-    _instructions[0x9F] = &CPU::op_axa<ABSY>;
-    _instructions[0x93] = &CPU::op_axa<INDY>;
-
-    _instructions[0x02] = &CPU::op_kil;
-    _instructions[0x12] = &CPU::op_kil;
-    _instructions[0x22] = &CPU::op_kil;
-    _instructions[0x32] = &CPU::op_kil;
-    _instructions[0x42] = &CPU::op_kil;
-    _instructions[0x52] = &CPU::op_kil;
-    _instructions[0x62] = &CPU::op_kil;
-    _instructions[0x72] = &CPU::op_kil;
-    _instructions[0x92] = &CPU::op_kil;
-    _instructions[0xB2] = &CPU::op_kil;
-    _instructions[0xD2] = &CPU::op_kil;
-    _instructions[0xF2] = &CPU::op_kil;
-
-    _instructions[0xBB] = &CPU::op_las;
-    _instructions[0x9E] = &CPU::op_sxa;
-    _instructions[0x9C] = &CPU::op_sya;
-    _instructions[0x8B] = &CPU::op_xaa;
-    _instructions[0x9B] = &CPU::op_xas;
-}
+// Indexed by opcode. Cycles are the base count without page crossing and taken branch penalties.
+const CPU::Opcode CPU::OPCODES[0x100] = {
+#define OPCODE(opcode, handler, mnemonic, mode, cycles, length, pageCrossPenalty) \
+    { &CPU::handler, mnemonic, mode, cycles, length, pageCrossPenalty },
+#include "Opcodes.def"
+#undef OPCODE
+};
 
 template <typename AccessMode>
 cpu_cycle_t CPU::op_adc()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     _registers.A = _add(am.read());
     return am.getCycles();
 }
@@ -434,7 +413,7 @@ cpu_cycle_t CPU::op_adc()
 template <typename AccessMode>
 cpu_cycle_t CPU::op_and()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     uint8_t operand = am.read();
     _registers.A = _and(operand, _registers.A);
 
@@ -444,7 +423,7 @@ cpu_cycle_t CPU::op_and()
 template <typename AccessMode>
 cpu_cycle_t CPU::op_asl()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     uint8_t operand = am.read();
     am.write(_asl(operand));
     return am.getCycles();
@@ -453,10 +432,11 @@ cpu_cycle_t CPU::op_asl()
 template <typename AccessMode>
 cpu_cycle_t CPU::op_bit()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     uint8_t operand = am.read();
     uint8_t result = _registers.A & operand;
 
+    _lazyPending = false;
     _registers.setFlag(Registers::Flags::N, operand & 0x80);
     _registers.setFlag(Registers::Flags::V, operand & 0x40);
     _registers.setFlag(Registers::Flags::Z, result == 0);
@@ -467,7 +447,7 @@ cpu_cycle_t CPU::op_bit()
 template <typename AccessMode>
 cpu_cycle_t CPU::op_cmp()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     uint8_t operand = am.read();
     uint8_t diff = _registers.A - operand;
 
@@ -480,7 +460,7 @@ cpu_cycle_t CPU::op_cmp()
 template <typename AccessMode>
 cpu_cycle_t CPU::op_cpx()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     uint8_t operand = am.read();
     uint8_t result = _registers.X - operand;
 
@@ -493,7 +473,7 @@ cpu_cycle_t CPU::op_cpx()
 template <typename AccessMode>
 cpu_cycle_t CPU::op_cpy()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     uint8_t operand = am.read();
     uint8_t result = _registers.Y - operand;
 
@@ -506,7 +486,7 @@ cpu_cycle_t CPU::op_cpy()
 template <typename AccessMode>
 cpu_cycle_t CPU::op_dec()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     int8_t operand = am.read();
 
     operand--;
@@ -519,7 +499,7 @@ cpu_cycle_t CPU::op_dec()
 template <typename AccessMode>
 cpu_cycle_t CPU::op_eor()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     _registers.A = _eor(_registers.A, am.read());
     return am.getCycles();
 }
@@ -527,7 +507,7 @@ cpu_cycle_t CPU::op_eor()
 template <typename AccessMode>
 cpu_cycle_t CPU::op_inc()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     int8_t operand = am.read();
 
     operand++;
@@ -540,7 +520,7 @@ cpu_cycle_t CPU::op_inc()
 template <typename AccessMode>
 cpu_cycle_t CPU::op_lda()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     _registers.A = am.read();
     updateZNFlags(_registers.A);
 
@@ -550,7 +530,7 @@ cpu_cycle_t CPU::op_lda()
 template <typename AccessMode>
 cpu_cycle_t CPU::op_ldx()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     _registers.X = am.read();
     updateZNFlags(_registers.X);
 
@@ -560,7 +540,7 @@ cpu_cycle_t CPU::op_ldx()
 template <typename AccessMode>
 cpu_cycle_t CPU::op_ldy()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     _registers.Y = am.read();
     updateZNFlags(_registers.Y);
 
@@ -570,7 +550,7 @@ cpu_cycle_t CPU::op_ldy()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_lsr()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     am.write(_lsr(am.read()));
     return am.getCycles();
 }
@@ -578,7 +558,7 @@ cpu_cycle_t CPU::op_lsr()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_ora()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     uint8_t operand = am.read();
     _registers.A = _or(_registers.A, operand);
     return am.getCycles();
@@ -587,7 +567,7 @@ cpu_cycle_t CPU::op_ora()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_rol()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     am.write(_rol(am.read()));
     return am.getCycles();
 }
@@ -595,7 +575,7 @@ cpu_cycle_t CPU::op_rol()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_ror()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     am.write(_ror(am.read()));
     return am.getCycles();
 }
@@ -603,7 +583,7 @@ cpu_cycle_t CPU::op_ror()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_sbc()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     _registers.A = _add(~am.read());
     return am.getCycles();
 }
@@ -611,7 +591,7 @@ cpu_cycle_t CPU::op_sbc()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_sta()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     am.write(_registers.A);
     return am.getCycles();
 }
@@ -619,7 +599,7 @@ cpu_cycle_t CPU::op_sta()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_stx()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     am.write(_registers.X);
     return am.getCycles();
 }
@@ -627,7 +607,7 @@ cpu_cycle_t CPU::op_stx()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_sty()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     am.write(_registers.Y);
     return am.getCycles();
 }
@@ -635,7 +615,7 @@ cpu_cycle_t CPU::op_sty()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_lax()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     uint8_t operand = am.read();
     _registers.A = operand;
     _registers.X = operand;
@@ -647,7 +627,7 @@ cpu_cycle_t CPU::op_lax()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_sax()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     am.write(_registers.A & _registers.X);
     return am.getCycles();
 }
@@ -655,7 +635,7 @@ cpu_cycle_t CPU::op_sax()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_dcp()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     uint8_t operand = am.read();
     operand--;
 
@@ -670,7 +650,7 @@ cpu_cycle_t CPU::op_dcp()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_isc()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     uint8_t operand = am.read();
     operand++;
 
@@ -682,7 +662,7 @@ cpu_cycle_t CPU::op_isc()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_rla()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     uint8_t operand = am.read();
     operand = _rol(operand);
     _registers.A = _and(_registers.A, operand);
@@ -694,7 +674,7 @@ cpu_cycle_t CPU::op_rla()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_rra()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     uint8_t operand = am.read();
     operand = _ror(operand);
     _registers.A = _add(operand);
@@ -706,7 +686,7 @@ cpu_cycle_t CPU::op_rra()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_slo()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     uint8_t operand = am.read();
     operand = _asl(operand);
     _registers.A = _or(_registers.A, operand);
@@ -718,7 +698,7 @@ cpu_cycle_t CPU::op_slo()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_sre()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     uint8_t operand = am.read();
     operand = _lsr(operand);
     _registers.A = _eor(_registers.A, operand);
@@ -730,7 +710,7 @@ cpu_cycle_t CPU::op_sre()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_skb()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     am.read();
     return am.getCycles();
 }
@@ -738,7 +718,7 @@ cpu_cycle_t CPU::op_skb()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_ign()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     am.read();
     return am.getCycles();
 }
@@ -746,7 +726,7 @@ cpu_cycle_t CPU::op_ign()
 template<typename AccessMode>
 cpu_cycle_t CPU::op_axa()
 {
-    AccessMode am(_registers, _memory.get());
+    AccessMode am(_registers, _memory.get(), _cachedOperand);
     uint8_t result = _registers.X & _registers.A;
     result &= 7;
     am.write(result);
@@ -770,7 +750,7 @@ cpu_cycle_t CPU::op_iny()
 
 cpu_cycle_t CPU::op_jmp_abs()
 {
-    auto address = _memory->readShort(_registers.PC);
+    auto address = Operand(_registers, _memory.get(), _cachedOperand).readShort();
     _registers.PC = address;
 
     return 2;
@@ -778,7 +758,7 @@ cpu_cycle_t CPU::op_jmp_abs()
 
 cpu_cycle_t CPU::op_jmp_ind()
 {
-    uint16_t base = _memory->readShort(_registers.PC);
+    uint16_t base = Operand(_registers, _memory.get(), _cachedOperand).readShort();
     uint16_t address = 0;
     if ((base & 0xFF) == 0xFF)
     {
@@ -798,7 +778,7 @@ cpu_cycle_t CPU::op_jmp_ind()
 cpu_cycle_t CPU::op_jsr()
 {
     _memory->pushShort(_registers.S, _registers.PC + 1);
-    _registers.PC = _memory->readShort(_registers.PC);
+    _registers.PC = Operand(_registers, _memory.get(), _cachedOperand).readShort();
 
     return 6;
 }
@@ -835,6 +815,7 @@ cpu_cycle_t CPU::op_bpl()
 
 cpu_cycle_t CPU::op_brk()
 {
+    resolveFlags();
     _memory->pushShort(_registers.S, _registers.PC + 1);
     _memory->pushByte(_registers.S, _registers.P);
     _registers.PC = _memory->readShort(CPUMemory::IRQ_VECTOR);
@@ -868,6 +849,7 @@ cpu_cycle_t CPU::op_cld()
 cpu_cycle_t CPU::op_cli()
 {
     _registers.setFlag(Registers::Flags::I, false);
+    pollIrq();
     return 1;
 }
 
@@ -904,6 +886,7 @@ cpu_cycle_t CPU::op_pha()
 
 cpu_cycle_t CPU::op_php()
 {
+    resolveFlags();
     _memory->pushByte(_registers.S, _registers.P);
     return 2;
 }
@@ -919,6 +902,8 @@ cpu_cycle_t CPU::op_plp()
 {
     _registers.P = _memory->popByte(_registers.S);
     _registers.P |= Registers::Flags::B | Registers::Flags::L;
+    _lazyPending = false;
+    pollIrq();
     return 3;
 }
 
@@ -926,7 +911,9 @@ cpu_cycle_t CPU::op_rti()
 {
     _registers.P = _memory->popByte(_registers.S);
     _registers.P |= Registers::Flags::B | Registers::Flags::L;
+    _lazyPending = false;
     _registers.PC = _memory->popShort(_registers.S);
+    pollIrq();
     return 5;
 }
 
@@ -997,7 +984,7 @@ cpu_cycle_t CPU::op_txs()
 
 cpu_cycle_t CPU::op_alr()
 {
-    IMM am(_registers, _memory.get());
+    IMM am(_registers, _memory.get(), _cachedOperand);
     _registers.A = _and(_registers.A, am.read());
     _registers.A = _lsr(_registers.A);
 
@@ -1006,15 +993,15 @@ cpu_cycle_t CPU::op_alr()
 
 cpu_cycle_t CPU::op_anc()
 {
-    IMM am(_registers, _memory.get());
+    IMM am(_registers, _memory.get(), _cachedOperand);
     _registers.A = _and(am.read(), _registers.A);
-    _registers.setFlag(Registers::Flags::C, _registers.getFlag(Registers::Flags::N));
+    _registers.setFlag(Registers::Flags::C, getFlag(Registers::Flags::N));
     return 1;
 }
 
 cpu_cycle_t CPU::op_arr()
 {
-    IMM am(_registers, _memory.get());
+    IMM am(_registers, _memory.get(), _cachedOperand);
     _registers.A = _and(am.read(), _registers.A);
     _registers.A = _ror(_registers.A);
 
@@ -1029,7 +1016,7 @@ cpu_cycle_t CPU::op_arr()
 
 cpu_cycle_t CPU::op_axs()
 {
-    IMM am(_registers, _memory.get());
+    IMM am(_registers, _memory.get(), _cachedOperand);
     uint8_t operand = am.read();
     uint16_t result = (_registers.A & _registers.X) - operand;
 
@@ -1048,7 +1035,7 @@ cpu_cycle_t CPU::op_kil()
 
 cpu_cycle_t CPU::op_las()
 {
-    ABSY am(_registers, _memory.get());
+    ABSY am(_registers, _memory.get(), _cachedOperand);
     uint8_t result = _and(am.read(), _registers.S);
     _registers.A = result;
     _registers.X = result;
@@ -1059,8 +1046,7 @@ cpu_cycle_t CPU::op_las()
 
 cpu_cycle_t CPU::op_sxa()
 {
-    uint16_t address = _memory->readShort(_registers.PC) + _registers.Y;
-    _registers.PC += 2;
+    uint16_t address = Operand(_registers, _memory.get(), _cachedOperand).fetchShort() + _registers.Y;
 
     uint8_t al = address & 0xFF;
     uint8_t ah = address >> 8;
@@ -1072,8 +1058,7 @@ cpu_cycle_t CPU::op_sxa()
 
 cpu_cycle_t CPU::op_sya()
 {
-    uint16_t address = _memory->readShort(_registers.PC) + _registers.X;
-    _registers.PC += 2;
+    uint16_t address = Operand(_registers, _memory.get(), _cachedOperand).fetchShort() + _registers.X;
 
     uint8_t al = address & 0xFF;
     uint8_t ah = address >> 8;
@@ -1085,7 +1070,7 @@ cpu_cycle_t CPU::op_sya()
 
 cpu_cycle_t CPU::op_xaa()
 {
-    IMM am(_registers, _memory.get());
+    IMM am(_registers, _memory.get(), _cachedOperand);
     am.read();
 
     // exact operation unknown
@@ -1094,7 +1079,7 @@ cpu_cycle_t CPU::op_xaa()
 
 cpu_cycle_t CPU::op_xas()
 {
-    ABSY am(_registers, _memory.get());
+    ABSY am(_registers, _memory.get(), _cachedOperand);
     uint16_t operand = am.getAddress() >> 8;
     operand++;
 
@@ -1106,10 +1091,11 @@ cpu_cycle_t CPU::op_xas()
 
 cpu_cycle_t CPU::branchOnFlag(CPU::Registers::Flags flag, bool state)
 {
-    if (_registers.getFlag(flag) == state)
+    if (getFlag(flag) == state)
     {
-        auto offset = static_cast<int8_t>(_memory->readByte(_registers.PC++));
+        auto offset = static_cast<int8_t>(Operand(_registers, _memory.get(), _cachedOperand).fetchByte());
         auto jump = _registers.PC + offset;
+        _idleLoopCandidate = _idleLoopSkip && (offset == -4 || offset == -5);
         auto page = _registers.PC & 0xFF00;
         auto jumpPage = jump & 0xFF00;
         _registers.PC = jump;
@@ -1134,8 +1120,7 @@ uint8_t CPU::_add(uint8_t value)
 
     _registers.setFlag(Registers::Flags::C, result > 0xFF);
     _registers.setFlag(Registers::Flags::V, ~(_registers.A ^ value) & (_registers.A ^ result) & 0x80);
-    _registers.setFlag(Registers::Flags::Z, static_cast<uint8_t>(result) == 0);
-    _registers.setFlag(Registers::Flags::N, static_cast<uint8_t>(result) & 0x80);
+    updateZNFlags(static_cast<uint8_t>(result));
     return static_cast<uint8_t>(result);
 }
 
@@ -1165,8 +1150,7 @@ uint8_t CPU::_lsr(uint8_t value)
     uint8_t result = value >> 1;
 
     _registers.setFlag(Registers::Flags::C, value & 1);
-    _registers.setFlag(Registers::Flags::N, false);;
-    _registers.setFlag(Registers::Flags::Z, result == 0);
+    updateZNFlags(result);
 
     return result;
 }
@@ -1198,10 +1182,68 @@ uint8_t CPU::_rol(uint8_t value)
     return result;
 }
 
+void CPU::compare(uint8_t a, uint8_t b)
+{
+    updateZNFlags(a - b);
+    _registers.setFlag(Registers::Flags::C, a >= b);
+}
+
+// In lazy mode only the result is recorded, N and Z are derived from it once P is observed
 void CPU::updateZNFlags(uint8_t value)
 {
+    if (_lazyFlags)
+    {
+        _lazyResult = value;
+        _lazyPending = true;
+        return;
+    }
+
     _registers.setFlag(Registers::Flags::Z, value == 0);
     _registers.setFlag(Registers::Flags::N, value & 0x80);
 }
 
+bool CPU::getFlag(Registers::Flags flag) const
+{
+    if (_lazyPending && flag == Registers::Flags::Z)
+    {
+        return _lazyResult == 0;
+    }
+    if (_lazyPending && flag == Registers::Flags::N)
+    {
+        return _lazyResult & 0x80;
+    }
+
+    return _registers.getFlag(flag);
+}
+
+void CPU::resolveFlags()
+{
+    if (_lazyPending)
+    {
+        _lazyPending = false;
+        _registers.setFlag(Registers::Flags::Z, _lazyResult == 0);
+        _registers.setFlag(Registers::Flags::N, _lazyResult & 0x80);
+    }
+}
+
+cpu_cycle_t CPU::dispatch(uint8_t opcode)
+{
+    return (this->*OPCODES[opcode].handler)();
 }
+
+// Same mapping as OPCODES, but every handler is called directly so the
+// compiler can inline the op_* bodies into a single jump table.
+cpu_cycle_t CPU::execute(uint8_t opcode)
+{
+    switch (opcode)
+    {
+#define OPCODE(opcode, handler, mnemonic, mode, cycles, length, pageCrossPenalty) \
+        case opcode: return handler();
+#include "Opcodes.def"
+#undef OPCODE
+    }
+
+    throw std::runtime_error("Invalid opcode: " + std::to_string(opcode));
+}
+
+}
\ No newline at end of file
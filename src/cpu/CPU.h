@@ -1,6 +1,7 @@
 #ifndef NESEMU_CPU_H
 #define NESEMU_CPU_H
 
+#include <cstdint>
 #include <vector>
 #include <memory>
 #include <functional>
@@ -8,16 +9,17 @@
 namespace nescore
 {
 
-typedef unsigned int cpu_cycle_t;
+typedef uint64_t cpu_cycle_t;
 
 class CPUMemory;
+class Scheduler;
+class BlockCache;
 
 class CPU
 {
-private:
+public:
     using InstructionHandler = cpu_cycle_t (CPU::*)();
 
-public:
     struct Registers
     {
         enum Flags
@@ -46,20 +48,80 @@ public:
         bool getFlag(Flags flag) const;
     };
 
+    enum DispatchMode
+    {
+        Table,
+        Switch
+    };
+
+    enum AddressingMode
+    {
+        Implied,
+        Accumulator,
+        Immediate,
+        ZeroPage,
+        ZeroPageX,
+        ZeroPageY,
+        Absolute,
+        AbsoluteX,
+        AbsoluteY,
+        Indirect,
+        IndirectX,
+        IndirectY,
+        Relative
+    };
+
+    struct Opcode
+    {
+        InstructionHandler handler;
+        const char* mnemonic;
+        AddressingMode mode;
+        uint8_t cycles;
+        uint8_t length;
+        bool pageCrossPenalty;
+    };
+
+    static const Opcode OPCODES[0x100];
+
 public:
     CPU();
+    explicit CPU(std::shared_ptr<CPUMemory> memory);
     CPU(const std::vector<uint8_t>& operations);
+    CPU(const CPU&) = delete;
+    ~CPU();
 
     void reset();
     void tick();
     void tick(int count);
+    cpu_cycle_t runFor(cpu_cycle_t budget);
+    template <typename Predicate> cpu_cycle_t runUntil(Predicate predicate);
+    void stop();
     void startDmaTransfer();
+    void nmi();
+    void setIrq(bool active);
+    void setDispatchMode(DispatchMode mode);
+    DispatchMode getDispatchMode() const;
+    void setBlockCacheEnabled(bool enabled);
+    bool isBlockCacheEnabled() const;
+    void setLazyFlagsEnabled(bool enabled);
+    bool isLazyFlagsEnabled() const;
+    void setIdleLoopSkipEnabled(bool enabled);
+    bool isIdleLoopSkipEnabled() const;
     Registers& getRegisters();
+    Registers getRegisters() const;
     std::shared_ptr<CPUMemory> getMemory();
+    std::shared_ptr<Scheduler> getScheduler();
     cpu_cycle_t getCycle() const;
 
 private:
-    void setupInstructions();
+    void step();
+    bool runBlock(cpu_cycle_t limit);
+    bool skipIdleLoop(cpu_cycle_t limit);
+    void setupEvents();
+    void interrupt(uint16_t vector);
+    void pollIrq();
+    cpu_cycle_t dispatch(uint8_t opcode);
+    cpu_cycle_t execute(uint8_t opcode);
 
     template <typename AccessMode> cpu_cycle_t op_adc();
     template <typename AccessMode> cpu_cycle_t op_and();
@@ -153,17 +215,50 @@ private:
     uint8_t _asl(uint8_t value);
     uint8_t _ror(uint8_t value);
     uint8_t _rol(uint8_t value);
+    void compare(uint8_t a, uint8_t b);
     void updateZNFlags(uint8_t value);
+    bool getFlag(Registers::Flags flag) const;
+    void resolveFlags();
 
 private:
     std::shared_ptr<CPUMemory> _memory;
+    std::shared_ptr<Scheduler> _scheduler;
+    std::unique_ptr<BlockCache> _blockCache;
     Registers _registers;
-    InstructionHandler _instructions[0x100];
     cpu_cycle_t _cycle;
     cpu_cycle_t _dmaCycle;
+    DispatchMode _dispatchMode;
     bool _killed;
+    bool _stopped;
+    bool _irq;
+    bool _lazyFlags;
+    bool _lazyPending;
+    uint8_t _lazyResult;
+    // Operand bytes of the block cache instruction being run, null while stepping
+    const uint8_t* _cachedOperand;
+    bool _idleLoopSkip;
+    bool _idleLoopCandidate;
 };
 
+// Runs until predicate(const CPU&) returns true after an instruction, the CPU is stopped or killed.
+// Returns the number of cycles spent.
+template <typename Predicate>
+cpu_cycle_t CPU::runUntil(Predicate predicate)
+{
+    auto start = _cycle;
+    _stopped = false;
+    while (!_killed && !_stopped)
+    {
+        step();
+        if (predicate(static_cast<const CPU&>(*this)))
+        {
+            break;
+        }
+    }
+
+    return _cycle - start;
+}
+
 }
 
 #endif //NESEMU_CPU_H
@@ -1,3 +1,4 @@
+#include <memory.h>
 #include "CPUMemory.h"
 
 namespace nescore
@@ -7,15 +8,24 @@ const Memory::Range CPUMemory::RAM = Range(0x0000, 0xFFFF);
 const Memory::Range CPUMemory::RAM_MIRROR_1 = Range(0x0800, 0x0FFF);
 const Memory::Range CPUMemory::RAM_MIRROR_2 = Range(0x1000, 0x17FF);
 const Memory::Range CPUMemory::RAM_MIRROR_3 = Range(0x1800, 0x1FFF);
+const Memory::Range CPUMemory::INTERNAL_RAM = Range(0x0000, 0x07FF);
 
-CPUMemory::CPUMemory()
-    : _ram(new uint8_t[0x10000])
+CPUMemory::CPUMemory(Layout layout)
+    : _layout(layout)
+    , _ram(new uint8_t[layout == Layout::Flat ? 0x10000 : RAM_SIZE]())
 {
-    mount(RAM, _ram);
+    if (layout == Layout::Flat)
+    {
+        mount(RAM, _ram);
 
-    mirror(RAM, RAM_MIRROR_1);
-    mirror(RAM, RAM_MIRROR_2);
-    mirror(RAM, RAM_MIRROR_3);
+        mirror(INTERNAL_RAM, RAM_MIRROR_1);
+        mirror(INTERNAL_RAM, RAM_MIRROR_2);
+        mirror(INTERNAL_RAM, RAM_MIRROR_3);
+    }
+    else
+    {
+        mount(Range(INTERNAL_RAM.start, RAM_MIRROR_3.end), _ram, RAM_SIZE);
+    }
 
     setStackOffset(STACK_OFFSET);
 }
@@ -33,6 +43,11 @@ CPUMemory::~CPUMemory()
 
 void CPUMemory::loadProgram(const std::vector<uint8_t> &program)
 {
+    if (_layout != Layout::Flat)
+    {
+        throw nes_memory_error("Programs can only be loaded into flat memory");
+    }
+
     memcpy(_ram + ROM_OFFSET, program.data(), program.size());
 }
 
@@ -41,4 +56,9 @@ void CPUMemory::setResetVector(uint16_t offset)
     writeShort(RESET_VECTOR, offset);
 }
 
+CPUMemory::Layout CPUMemory::getLayout() const
+{
+    return _layout;
+}
+
 }
\ No newline at end of file
@@ -7,29 +7,42 @@
 namespace nescore
 {
 
-class CPUMemory : public Memory
+class CPUMemory final : public Memory
 {
 public:
     static const Range RAM;
     static const Range RAM_MIRROR_1;
     static const Range RAM_MIRROR_2;
     static const Range RAM_MIRROR_3;
+    static const Range INTERNAL_RAM;
 
+    static const uint16_t RAM_SIZE = 0x0800;
     static const uint16_t ROM_OFFSET = 0x8000;
     static const uint16_t RESET_VECTOR = 0xFFFC;
     static const uint16_t IRQ_VECTOR = 0xFFFE;
     static const uint16_t NMI_VECTOR = 0xFFFA;
     static const uint16_t STACK_OFFSET = 0x0100;
 
+    // Flat backs the whole address space with RAM, which is what instruction tests expect.
+    // Compact only has the 2 KiB of internal RAM. Everything else is mounted by the mapper and I/O;
+    // unmapped addresses read open bus and ignore writes.
+    enum Layout
+    {
+        Flat,
+        Compact
+    };
+
 public:
-    CPUMemory();
+    explicit CPUMemory(Layout layout = Layout::Flat);
     CPUMemory(const std::vector<uint8_t>& ram);
     ~CPUMemory();
 
     void loadProgram(const std::vector<uint8_t>& program);
     void setResetVector(uint16_t offset);
+    Layout getLayout() const;
 
 private:
+    Layout _layout;
     uint8_t* _ram;
 };
 
@@ -3,6 +3,7 @@
 
 #include "../CPU.h"
 #include "../CPUMemory.h"
+#include "Operand.h"
 
 namespace nescore
 {
@@ -10,9 +11,10 @@ namespace nescore
 class ABS
 {
 public:
-    ABS(CPU::Registers& registers, CPUMemory* memory)
+    ABS(CPU::Registers& registers, CPUMemory* memory, const uint8_t* operand)
         : _registers(registers)
         , _memory(memory)
+        , _operand(registers, memory, operand)
         , _cycles(0)
         , _rw(false)
     {}
@@ -20,8 +22,7 @@ public:
     uint8_t read()
     {
         _cycles= 3;
-        _address = _memory->readShort(_registers.PC);
-        _registers.PC += 2;
+        _address = _operand.fetchShort();
         _rw = true;
         return _memory->readByte(_address);
     }
@@ -30,8 +31,7 @@ public:
     {
         if (!_rw)
         {
-            _address = _memory->readShort(_registers.PC);
-            _registers.PC += 2;
+            _address = _operand.fetchShort();
         }
 
         _cycles = _rw ? 5 : 3;
@@ -46,6 +46,7 @@ public:
 private:
     CPU::Registers& _registers;
     CPUMemory* _memory;
+    Operand _operand;
     uint16_t _address;
     cpu_cycle_t _cycles;
     bool _rw;
@@ -3,6 +3,7 @@
 
 #include "../CPU.h"
 #include "../CPUMemory.h"
+#include "Operand.h"
 
 namespace nescore
 {
@@ -10,9 +11,10 @@ namespace nescore
 class ABSX
 {
 public:
-    ABSX(CPU::Registers& registers, CPUMemory* memory)
+    ABSX(CPU::Registers& registers, CPUMemory* memory, const uint8_t* operand)
         : _registers(registers)
         , _memory(memory)
+        , _operand(registers, memory, operand)
         , _cycles(0)
         , _rw(false)
     {}
@@ -20,7 +22,7 @@ public:
     uint8_t read()
     {
         _cycles = 3;
-        _address = _memory->readShort(_registers.PC);
+        _address = _operand.readShort();
         if (_address & 0xFF + _registers.X > 0xFF)
         {
             _cycles++;
@@ -36,8 +38,7 @@ public:
     {
         if (!_rw)
         {
-            _address = _memory->readShort(_registers.PC) + _registers.X;
-            _registers.PC += 2;
+            _address = _operand.fetchShort() + _registers.X;
         }
 
         _cycles = _rw ? 6 : 4;
@@ -46,7 +47,7 @@ public:
 
     uint16_t getAddress()
     {
-        return _memory->readShort(_registers.PC) + _registers.X;
+        return _operand.readShort() + _registers.X;
     }
 
     cpu_cycle_t getCycles() const
@@ -57,6 +58,7 @@ public:
 private:
     CPU::Registers& _registers;
     CPUMemory* _memory;
+    Operand _operand;
     uint16_t _address;
     cpu_cycle_t _cycles;
     bool _rw;
@@ -3,6 +3,7 @@
 
 #include "../CPU.h"
 #include "../CPUMemory.h"
+#include "Operand.h"
 
 namespace nescore
 {
@@ -10,9 +11,10 @@ namespace nescore
 class ABSY
 {
 public:
-    ABSY(CPU::Registers& registers, CPUMemory* memory)
+    ABSY(CPU::Registers& registers, CPUMemory* memory, const uint8_t* operand)
         : _registers(registers)
         , _memory(memory)
+        , _operand(registers, memory, operand)
         , _cycles(0)
         , _rw(false)
     {}
@@ -20,7 +22,7 @@ public:
     uint8_t read()
     {
         _cycles = 3;
-        _address = _memory->readShort(_registers.PC);
+        _address = _operand.readShort();
         if (_address & 0xFF + _registers.Y > 0xFF)
         {
             _cycles++;
@@ -36,8 +38,7 @@ public:
     {
         if (!_rw)
         {
-            _address = _memory->readShort(_registers.PC) + _registers.Y;
-            _registers.PC += 2;
+            _address = _operand.fetchShort() + _registers.Y;
         }
 
         _cycles = _rw ? 6 : 4;
@@ -46,7 +47,7 @@ public:
 
     uint16_t getAddress()
     {
-        return _memory->readShort(_registers.PC) + _registers.Y;
+        return _operand.readShort() + _registers.Y;
     }
 
     cpu_cycle_t getCycles() const
@@ -57,6 +58,7 @@ public:
 private:
     CPU::Registers& _registers;
     CPUMemory* _memory;
+    Operand _operand;
     uint16_t _address;
     cpu_cycle_t _cycles;
     bool _rw;
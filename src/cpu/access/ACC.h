@@ -10,7 +10,7 @@ namespace nescore
 class ACC
 {
 public:
-    ACC(CPU::Registers& registers, CPUMemory* memory)
+    ACC(CPU::Registers& registers, CPUMemory* memory, const uint8_t* /* operand */)
         : _registers(registers)
         , _memory(memory)
     {}
@@ -3,6 +3,7 @@
 
 #include "../CPU.h"
 #include "../CPUMemory.h"
+#include "Operand.h"
 
 namespace nescore
 {
@@ -10,14 +11,15 @@ namespace nescore
 class IMM
 {
 public:
-    IMM(CPU::Registers& registers, CPUMemory* memory)
+    IMM(CPU::Registers& registers, CPUMemory* memory, const uint8_t* operand)
         : _registers(registers)
         , _memory(memory)
+        , _operand(registers, memory, operand)
     {}
 
     uint8_t read()
     {
-        return _memory->readByte(_registers.PC++);
+        return _operand.fetchByte();
     }
 
     cpu_cycle_t getCycles() const
@@ -28,6 +30,7 @@ public:
 private:
     CPU::Registers& _registers;
     CPUMemory* _memory;
+    Operand _operand;
 };
 
 }
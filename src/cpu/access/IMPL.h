@@ -10,7 +10,7 @@ namespace nescore
 class IMPL
 {
 public:
-    IMPL(CPU::Registers& registers, CPUMemory* memory)
+    IMPL(CPU::Registers& registers, CPUMemory* memory, const uint8_t* /* operand */)
         : _registers(registers)
         , _memory(memory)
     {}
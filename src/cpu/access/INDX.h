@@ -3,6 +3,7 @@
 
 #include "../CPU.h"
 #include "../CPUMemory.h"
+#include "Operand.h"
 
 namespace nescore
 {
@@ -10,16 +11,17 @@ namespace nescore
 class INDX
 {
 public:
-    INDX(CPU::Registers& registers, CPUMemory* memory)
+    INDX(CPU::Registers& registers, CPUMemory* memory, const uint8_t* operand)
         : _registers(registers)
         , _memory(memory)
+        , _operand(registers, memory, operand)
         , _cycles(0)
         , _rw(false)
     {}
 
     uint8_t read()
     {
-        _cycles = 4;
+        _cycles = 5;
         _address = getAddress();
         _rw = true;
 
@@ -45,7 +47,7 @@ public:
 private:
     uint16_t getAddress()
     {
-        uint8_t address = _memory->readByte(_registers.PC++) + _registers.X;
+        uint8_t address = _operand.fetchByte() + _registers.X;
         if (address == 0xFF)
         {
             return _memory->readByte(0xFF) | _memory->readByte(0x00) << 8;
@@ -57,6 +59,7 @@ private:
 private:
     CPU::Registers& _registers;
     CPUMemory* _memory;
+    Operand _operand;
     uint16_t _address;
     cpu_cycle_t _cycles;
     bool _rw;
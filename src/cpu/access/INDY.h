@@ -3,6 +3,7 @@
 
 #include "../CPU.h"
 #include "../CPUMemory.h"
+#include "Operand.h"
 
 namespace nescore
 {
@@ -10,9 +11,10 @@ namespace nescore
 class INDY
 {
 public:
-    INDY(CPU::Registers& registers, CPUMemory* memory)
+    INDY(CPU::Registers& registers, CPUMemory* memory, const uint8_t* operand)
         : _registers(registers)
         , _memory(memory)
+        , _operand(registers, memory, operand)
         , _cycles(0)
         , _rw(false)
     {}
@@ -45,7 +47,7 @@ public:
 private:
     uint16_t getAddress()
     {
-        uint8_t base = _memory->readByte(_registers.PC++);
+        uint8_t base = _operand.fetchByte();
         uint16_t address = 0;
         if (base == 0xFF)
         {
@@ -72,6 +74,7 @@ private:
 private:
     CPU::Registers& _registers;
     CPUMemory* _memory;
+    Operand _operand;
     uint16_t _address;
     cpu_cycle_t _cycles;
     bool _rw;
@@ -0,0 +1,53 @@
+#ifndef NESCORE_ACCESSOPERAND_H
+#define NESCORE_ACCESSOPERAND_H
+
+#include "../CPU.h"
+#include "../CPUMemory.h"
+
+namespace nescore
+{
+
+// Operand bytes of the current instruction, which start at PC. Instructions run from the block cache
+// hand in the bytes decoded with their block, so only instructions stepped one at a time fetch them.
+class Operand
+{
+public:
+    Operand(CPU::Registers& registers, CPUMemory* memory, const uint8_t* cached)
+        : _registers(registers)
+        , _memory(memory)
+        , _cached(cached)
+    {}
+
+    uint8_t readByte() const
+    {
+        return _cached ? _cached[0] : _memory->readByte(_registers.PC);
+    }
+
+    uint16_t readShort() const
+    {
+        return _cached ? _cached[0] | (_cached[1] << 8) : _memory->readShort(_registers.PC);
+    }
+
+    uint8_t fetchByte()
+    {
+        uint8_t value = readByte();
+        _registers.PC++;
+        return value;
+    }
+
+    uint16_t fetchShort()
+    {
+        uint16_t value = readShort();
+        _registers.PC += 2;
+        return value;
+    }
+
+private:
+    CPU::Registers& _registers;
+    CPUMemory* _memory;
+    const uint8_t* _cached;
+};
+
+}
+
+#endif //NESCORE_ACCESSOPERAND_H
@@ -3,6 +3,7 @@
 
 #include "../CPU.h"
 #include "../CPUMemory.h"
+#include "Operand.h"
 
 namespace nescore
 {
@@ -10,9 +11,10 @@ namespace nescore
 class ZP
 {
 public:
-    ZP(CPU::Registers& registers, CPUMemory* memory)
+    ZP(CPU::Registers& registers, CPUMemory* memory, const uint8_t* operand)
         : _registers(registers)
         , _memory(memory)
+        , _operand(registers, memory, operand)
         , _cycles(0)
         , _rw(false)
     {}
@@ -20,7 +22,7 @@ public:
     uint8_t read()
     {
         _cycles = 2;
-        _address = _memory->readByte(_registers.PC++);
+        _address = _operand.fetchByte();
         _rw = true;
         return _memory->readByte(_address);
     }
@@ -29,7 +31,7 @@ public:
     {
         if (!_rw)
         {
-            _address = _memory->readByte(_registers.PC++);
+            _address = _operand.fetchByte();
         }
 
         _cycles = _rw ? 4 : 2;
@@ -44,6 +46,7 @@ public:
 private:
     CPU::Registers& _registers;
     CPUMemory* _memory;
+    Operand _operand;
     uint16_t _address;
     cpu_cycle_t _cycles;
     bool _rw;
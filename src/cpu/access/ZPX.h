@@ -3,6 +3,7 @@
 
 #include "../CPU.h"
 #include "../CPUMemory.h"
+#include "Operand.h"
 
 namespace nescore
 {
@@ -10,9 +11,10 @@ namespace nescore
 class ZPX
 {
 public:
-    ZPX(CPU::Registers& registers, CPUMemory* memory)
+    ZPX(CPU::Registers& registers, CPUMemory* memory, const uint8_t* operand)
         : _registers(registers)
         , _memory(memory)
+        , _operand(registers, memory, operand)
         , _cycles(0)
         , _rw(false)
     {}
@@ -44,7 +46,7 @@ public:
 private:
     uint16_t readAddress()
     {
-        uint16_t address = _memory->readByte(_registers.PC++) + _registers.X;
+        uint16_t address = _operand.fetchByte() + _registers.X;
         address = address & 0xFF;
         return address;
     }
@@ -52,6 +54,7 @@ private:
 private:
     CPU::Registers& _registers;
     CPUMemory* _memory;
+    Operand _operand;
     uint16_t _address;
     cpu_cycle_t _cycles;
     bool _rw;
@@ -1,21 +1,35 @@
 #ifndef NESCORE_IROMMAPPER_H
 #define NESCORE_IROMMAPPER_H
 
+#include <cstdint>
 #include <memory>
 
 namespace nescore
 {
 
+class CPU;
 class IMemoryAccessor;
 class INESRom;
 class Memory;
+class PPUMemory;
 
+// Bank switching mappers declare their windows once with Memory::addBankWindow in setupCPU/setupPPU
+// and repoint them with Memory::switchBank, which never mounts anything new.
 class IRomMapper
 {
 public:
     virtual ~IRomMapper() {}
     virtual void setupCPU(std::shared_ptr<Memory> memory) = 0;
-    virtual void setupPPU(std::shared_ptr<Memory> memory) = 0;
+    virtual void setupPPU(std::shared_ptr<PPUMemory> memory) = 0;
+
+    // Gives mappers that raise IRQs the CPU they are plugged into
+    virtual void setupInterrupts(CPU* /* cpu */) {}
+
+    // Called for writes to ranges the mapper mounted itself on, with the full CPU address
+    virtual void writeRegister(uint16_t /* address */, uint8_t /* value */) {}
+
+    // Called by the PPU when background or sprite rendering is turned on or off
+    virtual void setRendering(bool /* enabled */) {}
 };
 
 }
@@ -0,0 +1,200 @@
+#include <memory.h>
+#include <algorithm>
+#include "MMC1.h"
+#include "../rom/INESRom.h"
+#include "../ppu/PPUMemory.h"
+
+namespace nescore
+{
+
+const Memory::Range MMC1::PRG_RAM = Memory::Range(0x6000, 0x7FFF);
+const Memory::Range MMC1::REGISTERS = Memory::Range(0x8000, 0xFFFF);
+
+namespace
+{
+
+enum Control
+{
+    MIRRORING = 0b00000011,
+    PRG_MODE = 0b00001100,
+    CHR_MODE = 0b00010000
+};
+
+enum PrgMode
+{
+    PRG_SWITCH_32K = 0b00000000,
+    PRG_FIX_FIRST = 0b00001000,
+    PRG_FIX_LAST = 0b00001100
+};
+
+}
+
+// Only the first 8 KiB of PRG RAM are mapped, larger RAM needs the SOROM/SXROM bank bits.
+// CHR RAM is at least 8 KiB, since both pattern tables are backed by it.
+MMC1::MMC1(std::shared_ptr<const INESRom> rom)
+    : _rom(rom)
+    , _prgRamSize(std::min<uint32_t>(rom->getPrgRamSize() + rom->getPrgNvramSize(), INESRom::PRG_RAM_BANK_SIZE))
+    , _chrRamSize(rom->getChrRomBanks() ? 0 : std::max<uint32_t>(rom->getChrRamSize() + rom->getChrNvramSize(),
+                                                                  INESRom::CHR_ROM_BANK_SIZE))
+    , _prgRam(_prgRamSize ? new uint8_t[_prgRamSize]() : nullptr)
+    , _chrRam(nullptr)
+    , _shift(0)
+    , _shiftCount(0)
+    , _control(PRG_FIX_LAST)
+    , _chrBank0(0)
+    , _chrBank1(0)
+    , _prgBank(0)
+{
+}
+
+MMC1::~MMC1()
+{
+    delete[] _prgRam;
+    delete[] _chrRam;
+}
+
+void MMC1::setupCPU(std::shared_ptr<Memory> memory)
+{
+    _cpuMemory = memory;
+    if (_prgRam)
+    {
+        memory->mount(PRG_RAM, _prgRam, _prgRamSize);
+    }
+
+    std::vector<const INESRom::Bank*> banks;
+    for (int i = 0; i < _rom->getPrgRomBanks(); ++i)
+    {
+        banks.push_back(_rom->getPrgRomBank(i));
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        _prgWindows[i] = memory->addBankWindow(Memory::Range::fromBank(2 + i, PRG_BANK_SIZE), banks);
+    }
+    memory->mountMapper(REGISTERS, this);
+
+    updatePrgBanks();
+}
+
+void MMC1::setupPPU(std::shared_ptr<PPUMemory> memory)
+{
+    _ppuMemory = memory;
+
+    std::vector<const INESRom::Bank*> banks;
+    for (int i = 0; i < _rom->getChrRomBanks(); ++i)
+    {
+        banks.push_back(_rom->getChrRomBank(i));
+    }
+    if (banks.empty() && !_chrRam)
+    {
+        _chrRam = new uint8_t[_chrRamSize]();
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        auto range = Memory::Range::fromBank(i, CHR_BANK_SIZE);
+        _chrWindows[i] = banks.empty() ? memory->addBankWindow(range, _chrRam, _chrRamSize)
+                                       : memory->addBankWindow(range, banks);
+    }
+
+    updateChrBanks();
+    updateMirroring();
+}
+
+// Handles reset writes and the fifth write, which completes a register
+void MMC1::loadRegister(uint16_t address, uint8_t value)
+{
+    if (value & SHIFT_RESET)
+    {
+        _shift = 0;
+        _shiftCount = 0;
+        _control |= PRG_FIX_LAST;
+        updatePrgBanks();
+        return;
+    }
+
+    _shift |= (value & 0x01) << _shiftCount;
+
+    // Bits 13 and 14 of the address of the fifth write select the register
+    switch (address & 0x6000)
+    {
+        case 0x0000:
+            _control = _shift;
+            updatePrgBanks();
+            updateChrBanks();
+            updateMirroring();
+            break;
+        case 0x2000:
+            _chrBank0 = _shift;
+            updateChrBanks();
+            break;
+        case 0x4000:
+            _chrBank1 = _shift;
+            updateChrBanks();
+            break;
+        case 0x6000:
+            _prgBank = _shift;
+            updatePrgBanks();
+            break;
+    }
+
+    _shift = 0;
+    _shiftCount = 0;
+}
+
+void MMC1::updatePrgBanks()
+{
+    if (!_cpuMemory)
+    {
+        return;
+    }
+
+    uint32_t bank = _prgBank & 0x0F;
+    uint32_t last = _rom->getPrgRomBanks() - 1;
+    switch (_control & PRG_MODE)
+    {
+        case PRG_FIX_FIRST:
+            _cpuMemory->switchBank(_prgWindows[0], 0);
+            _cpuMemory->switchBank(_prgWindows[1], bank);
+            break;
+        case PRG_FIX_LAST:
+            _cpuMemory->switchBank(_prgWindows[0], bank);
+            _cpuMemory->switchBank(_prgWindows[1], last);
+            break;
+        default:
+            _cpuMemory->switchBank(_prgWindows[0], bank & ~0x01);
+            _cpuMemory->switchBank(_prgWindows[1], bank | 0x01);
+            break;
+    }
+}
+
+void MMC1::updateChrBanks()
+{
+    if (!_ppuMemory)
+    {
+        return;
+    }
+
+    if (_control & CHR_MODE)
+    {
+        _ppuMemory->switchBank(_chrWindows[0], _chrBank0);
+        _ppuMemory->switchBank(_chrWindows[1], _chrBank1);
+    }
+    else
+    {
+        _ppuMemory->switchBank(_chrWindows[0], _chrBank0 & ~0x01);
+        _ppuMemory->switchBank(_chrWindows[1], _chrBank0 | 0x01);
+    }
+}
+
+void MMC1::updateMirroring()
+{
+    if (!_ppuMemory)
+    {
+        return;
+    }
+
+    static const INESRom::Mirroring MIRRORING_MODES[] = { INESRom::SINGLE_SCREEN_LOWER, INESRom::SINGLE_SCREEN_UPPER,
+                                                          INESRom::VERTICAL, INESRom::HORIZONTAL };
+    _ppuMemory->setMirroring(MIRRORING_MODES[_control & MIRRORING]);
+}
+
+}
@@ -0,0 +1,69 @@
+#ifndef NESCORE_MMC1_H
+#define NESCORE_MMC1_H
+
+#include "IRomMapper.h"
+#include "../memory/Memory.h"
+
+namespace nescore
+{
+
+// Mapper 1. Registers are loaded through a 5-bit serial shift register; the bank windows
+// are only switched once the fifth write completes a register.
+class MMC1 final : public IRomMapper
+{
+public:
+    static const Memory::Range PRG_RAM;
+    static const Memory::Range REGISTERS;
+    static const uint16_t PRG_BANK_SIZE = 0x4000;
+    static const uint16_t CHR_BANK_SIZE = 0x1000;
+    static const uint8_t SHIFT_RESET = 0b10000000;
+    static const uint8_t REGISTER_BITS = 5;
+    static const Memory::AccessorType ACCESSOR_TYPE = Memory::MMC1Register;
+
+public:
+    MMC1(std::shared_ptr<const INESRom> rom);
+    ~MMC1();
+
+    void setupCPU(std::shared_ptr<Memory> memory) override;
+    void setupPPU(std::shared_ptr<PPUMemory> memory) override;
+    void writeRegister(uint16_t address, uint8_t value) override;
+
+private:
+    void loadRegister(uint16_t address, uint8_t value);
+    void updatePrgBanks();
+    void updateChrBanks();
+    void updateMirroring();
+
+private:
+    std::shared_ptr<const INESRom> _rom;
+    std::shared_ptr<Memory> _cpuMemory;
+    std::shared_ptr<PPUMemory> _ppuMemory;
+    uint32_t _prgRamSize;
+    uint32_t _chrRamSize;
+    uint8_t* _prgRam;
+    uint8_t* _chrRam;
+    int _prgWindows[2];
+    int _chrWindows[2];
+    uint8_t _shift;
+    uint8_t _shiftCount;
+    uint8_t _control;
+    uint8_t _chrBank0;
+    uint8_t _chrBank1;
+    uint8_t _prgBank;
+};
+
+// The first four writes only shift a bit in, so they are kept inline for Memory's direct call
+inline void MMC1::writeRegister(uint16_t address, uint8_t value)
+{
+    if (!(value & SHIFT_RESET) && _shiftCount < REGISTER_BITS - 1)
+    {
+        _shift |= (value & 0x01) << _shiftCount++;
+        return;
+    }
+
+    loadRegister(address, value);
+}
+
+}
+
+#endif //NESCORE_MMC1_H
@@ -0,0 +1,355 @@
+#include <memory.h>
+#include <algorithm>
+#include "MMC3.h"
+#include "../rom/INESRom.h"
+#include "../ppu/PPUMemory.h"
+#include "../scheduler/Scheduler.h"
+
+namespace nescore
+{
+
+const Memory::Range MMC3::PRG_RAM = Memory::Range(0x6000, 0x7FFF);
+const Memory::Range MMC3::REGISTERS = Memory::Range(0x8000, 0xFFFF);
+
+namespace
+{
+
+const uint32_t DOTS_PER_SCANLINE = 341;
+const uint32_t DOTS_PER_FRAME = DOTS_PER_SCANLINE * 262;
+const uint32_t COUNTER_DOT = 260;
+const uint32_t VISIBLE_SCANLINES = 240;
+const uint32_t PRE_RENDER_SCANLINE = 261;
+const uint32_t CLOCKS_PER_FRAME = VISIBLE_SCANLINES + 1;
+
+enum PrgRamProtect
+{
+    WRITE_PROTECT = 0b01000000,
+    ENABLE = 0b10000000
+};
+
+}
+
+// PRG RAM is allocated as declared, up to 8 KiB, after a zeroed page for disabled reads and a sink page
+// for protected writes. Protection is handled by switching the read and write windows between them.
+// CHR RAM is at least 8 KiB, since both pattern tables are backed by it.
+MMC3::MMC3(std::shared_ptr<const INESRom> rom)
+    : _rom(rom)
+    , _cpu(nullptr)
+    , _prgRamSize(std::min<uint32_t>(rom->getPrgRamSize() + rom->getPrgNvramSize(), PRG_BANK_SIZE))
+    , _chrRamSize(rom->getChrRomBanks() ? 0 : std::max<uint32_t>(rom->getChrRamSize() + rom->getChrNvramSize(),
+                                                                  INESRom::CHR_ROM_BANK_SIZE))
+    , _prgRam(new uint8_t[Memory::PAGE_SIZE * 2 + ((_prgRamSize + Memory::PAGE_MASK) & ~Memory::PAGE_MASK)]())
+    , _chrRam(nullptr)
+    , _prgRamRead(-1)
+    , _prgRamWrite(-1)
+    , _bankSelect(0)
+    , _banks{ 0, 2, 4, 5, 6, 7, 0, 1 }
+    , _prgRamProtect(ENABLE)
+    , _counter(0)
+    , _latch(0)
+    , _reload(false)
+    , _irqEnabled(false)
+    , _rendering(false)
+    , _syncCycle(0)
+{
+}
+
+MMC3::~MMC3()
+{
+    delete[] _prgRam;
+    delete[] _chrRam;
+}
+
+void MMC3::setupCPU(std::shared_ptr<Memory> memory)
+{
+    _cpuMemory = memory;
+    // Bank 0 of the read window is the zero page and bank 1 the RAM, bank 0 of the write window is the RAM
+    // and bank 1 the sink. RAM smaller than the window is mirrored page by page, missing RAM is left at
+    // the zero page and the sink.
+    auto zero = _prgRam;
+    auto sink = _prgRam + Memory::PAGE_SIZE;
+    auto ram = _prgRam + Memory::PAGE_SIZE * 2;
+    uint32_t ramPages = (_prgRamSize + Memory::PAGE_MASK) >> Memory::PAGE_SHIFT;
+    std::vector<uint8_t*> readPages;
+    std::vector<uint8_t*> writePages;
+    for (uint32_t i = 0; i < PRG_BANK_SIZE / Memory::PAGE_SIZE; ++i)
+    {
+        readPages.push_back(zero);
+        writePages.push_back(ramPages ? ram + (i % ramPages) * Memory::PAGE_SIZE : sink);
+    }
+    for (uint32_t i = 0; i < PRG_BANK_SIZE / Memory::PAGE_SIZE; ++i)
+    {
+        readPages.push_back(ramPages ? ram + (i % ramPages) * Memory::PAGE_SIZE : zero);
+        writePages.push_back(sink);
+    }
+    _prgRamRead = memory->addBankWindow(PRG_RAM, readPages, Memory::Read, PRG_BANK_SIZE);
+    _prgRamWrite = memory->addBankWindow(PRG_RAM, writePages, Memory::Write, PRG_BANK_SIZE);
+
+    std::vector<const INESRom::Bank*> banks;
+    for (int i = 0; i < _rom->getPrgRomBanks(); ++i)
+    {
+        banks.push_back(_rom->getPrgRomBank(i));
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        _prgWindows[i] = memory->addBankWindow(Memory::Range::fromBank(4 + i, PRG_BANK_SIZE), banks);
+    }
+    memory->mountMapper(REGISTERS, this);
+
+    updatePrgRam();
+    updatePrgBanks();
+}
+
+void MMC3::setupPPU(std::shared_ptr<PPUMemory> memory)
+{
+    _ppuMemory = memory;
+
+    std::vector<const INESRom::Bank*> banks;
+    for (int i = 0; i < _rom->getChrRomBanks(); ++i)
+    {
+        banks.push_back(_rom->getChrRomBank(i));
+    }
+    if (banks.empty() && !_chrRam)
+    {
+        _chrRam = new uint8_t[_chrRamSize]();
+    }
+    for (int i = 0; i < 8; ++i)
+    {
+        auto range = Memory::Range::fromBank(i, CHR_BANK_SIZE);
+        _chrWindows[i] = banks.empty() ? memory->addBankWindow(range, _chrRam, _chrRamSize)
+                                       : memory->addBankWindow(range, banks);
+    }
+
+    updateChrBanks();
+    if (!_rom->getIgnoreMirroring())
+    {
+        memory->setMirroring(_rom->getMirroring());
+    }
+}
+
+void MMC3::setupInterrupts(CPU* cpu)
+{
+    _cpu = cpu;
+    _syncCycle = cpu->getCycle();
+    cpu->getScheduler()->setHandler(Scheduler::MapperIrq, [this](cpu_cycle_t deadline)
+    {
+        sync(deadline);
+        _cpu->setIrq(true);
+        scheduleIrq();
+    });
+    scheduleIrq();
+}
+
+void MMC3::writeRegister(uint16_t address, uint8_t value)
+{
+    switch (address & 0xE001)
+    {
+        case 0x8000:
+        {
+            bool modeChanged = (_bankSelect ^ value) & 0xC0;
+            _bankSelect = value;
+            if (modeChanged)
+            {
+                updatePrgBanks();
+                updateChrBanks();
+            }
+            break;
+        }
+        case 0x8001:
+        {
+            auto index = _bankSelect & 0x07;
+            _banks[index] = value;
+            if (index < 6)
+            {
+                updateChrBanks();
+            }
+            else
+            {
+                updatePrgBanks();
+            }
+            break;
+        }
+        case 0xA000:
+            if (_ppuMemory && !_rom->getIgnoreMirroring())
+            {
+                _ppuMemory->setMirroring(value & 0x01 ? INESRom::HORIZONTAL : INESRom::VERTICAL);
+            }
+            break;
+        case 0xA001:
+            _prgRamProtect = value;
+            updatePrgRam();
+            break;
+        case 0xC000:
+            sync();
+            _latch = value;
+            scheduleIrq();
+            break;
+        case 0xC001:
+            sync();
+            _counter = 0;
+            _reload = true;
+            scheduleIrq();
+            break;
+        case 0xE000:
+            sync();
+            _irqEnabled = false;
+            if (_cpu)
+            {
+                _cpu->setIrq(false);
+            }
+            scheduleIrq();
+            break;
+        case 0xE001:
+            sync();
+            _irqEnabled = true;
+            scheduleIrq();
+            break;
+    }
+}
+
+void MMC3::setRendering(bool enabled)
+{
+    sync();
+    _rendering = enabled;
+    scheduleIrq();
+}
+
+// Number of counter clocks that happened up to and including the given CPU cycle
+uint64_t MMC3::getClockCount(cpu_cycle_t cycle)
+{
+    uint64_t dot = cycle * 3 + 2;
+    uint64_t count = dot / DOTS_PER_FRAME * CLOCKS_PER_FRAME;
+    uint32_t frameDot = dot % DOTS_PER_FRAME;
+    if (frameDot >= COUNTER_DOT)
+    {
+        uint32_t scanline = (frameDot - COUNTER_DOT) / DOTS_PER_SCANLINE;
+        count += std::min(scanline, VISIBLE_SCANLINES - 1) + 1 + (scanline >= PRE_RENDER_SCANLINE ? 1 : 0);
+    }
+
+    return count;
+}
+
+// CPU cycle of the counter clock with the given zero based index
+cpu_cycle_t MMC3::getClockCycle(uint64_t clock)
+{
+    uint64_t frame = clock / CLOCKS_PER_FRAME;
+    uint32_t index = clock % CLOCKS_PER_FRAME;
+    uint32_t scanline = index < VISIBLE_SCANLINES ? index : PRE_RENDER_SCANLINE;
+    return (frame * DOTS_PER_FRAME + scanline * DOTS_PER_SCANLINE + COUNTER_DOT) / 3;
+}
+
+void MMC3::updatePrgBanks()
+{
+    if (!_cpuMemory)
+    {
+        return;
+    }
+
+    uint32_t last = _rom->getPrgRomBanks() * 2 - 1;
+    uint32_t r6 = _banks[6] & 0x3F;
+    bool swap = _bankSelect & 0x40;
+    _cpuMemory->switchBank(_prgWindows[0], swap ? last - 1 : r6);
+    _cpuMemory->switchBank(_prgWindows[1], _banks[7] & 0x3F);
+    _cpuMemory->switchBank(_prgWindows[2], swap ? r6 : last - 1);
+    _cpuMemory->switchBank(_prgWindows[3], last);
+}
+
+void MMC3::updateChrBanks()
+{
+    if (!_ppuMemory)
+    {
+        return;
+    }
+
+    // R0 and R1 select 2 KiB banks, so they cover two of the 1 KiB windows each
+    uint8_t banks[8] = { static_cast<uint8_t>(_banks[0] & 0xFE), static_cast<uint8_t>(_banks[0] | 0x01),
+                         static_cast<uint8_t>(_banks[1] & 0xFE), static_cast<uint8_t>(_banks[1] | 0x01),
+                         _banks[2], _banks[3], _banks[4], _banks[5] };
+    int inversion = _bankSelect & 0x80 ? 4 : 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        _ppuMemory->switchBank(_chrWindows[i ^ inversion], banks[i]);
+    }
+}
+
+void MMC3::updatePrgRam()
+{
+    if (!_cpuMemory)
+    {
+        return;
+    }
+
+    bool enabled = _prgRamProtect & ENABLE;
+    _cpuMemory->switchBank(_prgRamRead, enabled ? 1 : 0);
+    _cpuMemory->switchBank(_prgRamWrite, enabled && !(_prgRamProtect & WRITE_PROTECT) ? 0 : 1);
+}
+
+void MMC3::sync()
+{
+    if (_cpu)
+    {
+        sync(_cpu->getCycle());
+    }
+}
+
+// Catches the counter up with all clocks between the last sync and cycle
+void MMC3::sync(cpu_cycle_t cycle)
+{
+    if (cycle < _syncCycle)
+    {
+        return;
+    }
+    if (_rendering)
+    {
+        clockCounter(getClockCount(cycle) - getClockCount(_syncCycle));
+    }
+    _syncCycle = cycle;
+}
+
+void MMC3::clockCounter(uint64_t clocks)
+{
+    while (clocks > 0)
+    {
+        if (_counter == 0 || _reload)
+        {
+            // From zero the counter comes back to zero every latch + 1 clocks
+            if (!_reload)
+            {
+                clocks %= _latch + 1;
+                if (clocks == 0)
+                {
+                    break;
+                }
+            }
+            _counter = _latch;
+            _reload = false;
+            clocks--;
+            continue;
+        }
+
+        auto steps = std::min<uint64_t>(clocks, _counter);
+        _counter -= steps;
+        clocks -= steps;
+    }
+}
+
+void MMC3::scheduleIrq()
+{
+    if (!_cpu)
+    {
+        return;
+    }
+
+    auto scheduler = _cpu->getScheduler();
+    if (!_irqEnabled || !_rendering)
+    {
+        scheduler->cancel(Scheduler::MapperIrq);
+        return;
+    }
+
+    // The IRQ fires on the clock that leaves the counter at zero
+    uint64_t clocks = _counter == 0 || _reload ? _latch + 1 : _counter;
+    scheduler->schedule(Scheduler::MapperIrq, getClockCycle(getClockCount(_syncCycle) + clocks - 1));
+}
+
+}
@@ -0,0 +1,73 @@
+#ifndef NESCORE_MMC3_H
+#define NESCORE_MMC3_H
+
+#include "IRomMapper.h"
+#include "../memory/Memory.h"
+#include "../cpu/CPU.h"
+
+namespace nescore
+{
+
+// Mapper 4. PRG and CHR banks are bank windows, so bank switches never mount anything.
+// The scanline counter is not clocked by the PPU: it is caught up from the CPU cycle counter whenever its
+// registers are written, and the IRQ is scheduled as a MapperIrq event at the cycle the counter reaches zero.
+// The counter is assumed to be clocked at dot 260 of every visible and pre-render scanline while rendering
+// is on (background at $0000 and sprites at $1000), with the first frame starting at CPU cycle 0.
+class MMC3 final : public IRomMapper
+{
+public:
+    static const Memory::Range PRG_RAM;
+    static const Memory::Range REGISTERS;
+    static const uint16_t PRG_BANK_SIZE = 0x2000;
+    static const uint16_t CHR_BANK_SIZE = 0x400;
+    static const Memory::AccessorType ACCESSOR_TYPE = Memory::MMC3Register;
+
+public:
+    MMC3(std::shared_ptr<const INESRom> rom);
+    ~MMC3();
+
+    void setupCPU(std::shared_ptr<Memory> memory) override;
+    void setupPPU(std::shared_ptr<PPUMemory> memory) override;
+    void setupInterrupts(CPU* cpu) override;
+    void writeRegister(uint16_t address, uint8_t value) override;
+    void setRendering(bool enabled) override;
+
+    static uint64_t getClockCount(cpu_cycle_t cycle);
+    static cpu_cycle_t getClockCycle(uint64_t clock);
+
+private:
+    void updatePrgBanks();
+    void updateChrBanks();
+    void updatePrgRam();
+    void sync();
+    void sync(cpu_cycle_t cycle);
+    void clockCounter(uint64_t clocks);
+    void scheduleIrq();
+
+private:
+    std::shared_ptr<const INESRom> _rom;
+    std::shared_ptr<Memory> _cpuMemory;
+    std::shared_ptr<PPUMemory> _ppuMemory;
+    CPU* _cpu;
+    uint32_t _prgRamSize;
+    uint32_t _chrRamSize;
+    uint8_t* _prgRam;
+    uint8_t* _chrRam;
+    int _prgWindows[4];
+    int _chrWindows[8];
+    int _prgRamRead;
+    int _prgRamWrite;
+    uint8_t _bankSelect;
+    uint8_t _banks[8];
+    uint8_t _prgRamProtect;
+    uint8_t _counter;
+    uint8_t _latch;
+    bool _reload;
+    bool _irqEnabled;
+    bool _rendering;
+    cpu_cycle_t _syncCycle;
+};
+
+}
+
+#endif //NESCORE_MMC3_H
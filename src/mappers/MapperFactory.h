@@ -3,6 +3,8 @@
 
 #include <memory>
 #include "NROM.h"
+#include "MMC1.h"
+#include "MMC3.h"
 
 namespace nescore
 {
@@ -12,15 +14,19 @@ class MapperFactory
 public:
     enum MapperTypes
     {
-        MapperNROM = 0
+        MapperNROM = 0,
+        MapperMMC1 = 1,
+        MapperMMC3 = 4
     };
 
 public:
-    std::shared_ptr<IRomMapper> createMapper(std::shared_ptr<INESRom> rom)
+    std::shared_ptr<IRomMapper> createMapper(std::shared_ptr<const INESRom> rom)
     {
         switch (rom->getMapper())
         {
             case MapperNROM: return std::make_shared<NROM>(rom);
+            case MapperMMC1: return std::make_shared<MMC1>(rom);
+            case MapperMMC3: return std::make_shared<MMC3>(rom);
         }
 
         return nullptr;
@@ -1,6 +1,8 @@
 #include <memory.h>
+#include <algorithm>
 #include "NROM.h"
 #include "../rom/INESRom.h"
+#include "../ppu/PPUMemory.h"
 
 namespace nescore
 {
@@ -9,20 +11,29 @@ const Memory::Range NROM::PRG_RAM = Memory::Range(0x6000, 0x7FFF);
 const Memory::Range NROM::PRG_ROM_1 = Memory::Range(0x8000, 0xBFFF);
 const Memory::Range NROM::PRG_ROM_2 = Memory::Range(0xC000, 0xFFFF);
 
-NROM::NROM(std::shared_ptr<INESRom> rom)
+// RAM is allocated as declared by the header and mirrored over its range; boards without PRG RAM leave it unmapped
+NROM::NROM(std::shared_ptr<const INESRom> rom)
     : _rom(rom)
-    , _prgRam(new uint8_t[0x2000])
+    , _prgRamSize(std::min<uint32_t>(rom->getPrgRamSize() + rom->getPrgNvramSize(), INESRom::PRG_RAM_BANK_SIZE))
+    , _chrRamSize(rom->getChrRomBanks() ? 0 : std::min<uint32_t>(rom->getChrRamSize() + rom->getChrNvramSize(),
+                                                                  INESRom::CHR_ROM_BANK_SIZE))
+    , _prgRam(_prgRamSize ? new uint8_t[_prgRamSize]() : nullptr)
+    , _chrRam(_chrRamSize ? new uint8_t[_chrRamSize]() : nullptr)
 {
 }
 
 NROM::~NROM()
 {
     delete[] _prgRam;
+    delete[] _chrRam;
 }
 
 void NROM::setupCPU(std::shared_ptr<Memory> memory)
 {
-    memory->mount(PRG_RAM, _prgRam);
+    if (_prgRam)
+    {
+        memory->mount(PRG_RAM, _prgRam, _prgRamSize);
+    }
 
     if (_rom->getPrgRomBanks() == 2)
     {
@@ -36,12 +47,20 @@ void NROM::setupCPU(std::shared_ptr<Memory> memory)
     }
 }
 
-void NROM::setupPPU(std::shared_ptr<Memory> memory)
+void NROM::setupPPU(std::shared_ptr<PPUMemory> memory)
 {
     for (int i = 0; i < _rom->getChrRomBanks(); ++i)
     {
         memory->mount(Memory::Range::fromBank(i, INESRom::CHR_ROM_BANK_SIZE), _rom->getChrRomBank(i));
     }
+    if (_chrRam)
+    {
+        memory->mount(Memory::Range::fromBank(0, INESRom::CHR_ROM_BANK_SIZE), _chrRam, _chrRamSize);
+    }
+    if (!_rom->getIgnoreMirroring())
+    {
+        memory->setMirroring(_rom->getMirroring());
+    }
 }
 
 }
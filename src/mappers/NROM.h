@@ -7,7 +7,7 @@
 namespace nescore
 {
 
-class NROM : public IRomMapper
+class NROM final : public IRomMapper
 {
 public:
     static const Memory::Range PRG_RAM;
@@ -15,15 +15,18 @@ public:
     static const Memory::Range PRG_ROM_2;
 
 public:
-    NROM(std::shared_ptr<INESRom> rom);
+    NROM(std::shared_ptr<const INESRom> rom);
     ~NROM();
 
     void setupCPU(std::shared_ptr<Memory> memory) override;
-    void setupPPU(std::shared_ptr<Memory> memory) override;
+    void setupPPU(std::shared_ptr<PPUMemory> memory) override;
 
 private:
-    std::shared_ptr<INESRom> _rom;
+    std::shared_ptr<const INESRom> _rom;
+    uint32_t _prgRamSize;
+    uint32_t _chrRamSize;
     uint8_t* _prgRam;
+    uint8_t* _chrRam;
 
 };
 
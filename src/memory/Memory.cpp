@@ -1,18 +1,33 @@
+#include <memory.h>
+#include <algorithm>
 #include "Memory.h"
 #include "accessors/IMemoryAccessor.h"
-#include "accessors/BufferAccessor.h"
-#include "accessors/MirrorAccessor.h"
-#include "accessors/RomBankAccessor.h"
+#include "../ppu/registers/PPURegistersAccessor.h"
+#include "../ppu/registers/OamDmaAccessor.h"
+#include "../mappers/IRomMapper.h"
+#include "../mappers/MMC1.h"
+#include "../mappers/MMC3.h"
 
 namespace nescore
 {
 
-Memory::Mount::Mount(Memory::Range range, IMemoryAccessor *accessor)
+Memory::Mount::Mount(Memory::Range range, AccessorType type, uint8_t* data, uint32_t dataSize)
     : range(range)
-    , accessor(accessor)
+    , type(type)
+    , accessor(nullptr)
+    , mapper(nullptr)
+    , data(data)
+    , dataSize(dataSize)
+    , base(0)
+    , mask(0xFFFF)
 {
 }
 
+uint16_t Memory::Mount::getLocalOffset(uint16_t offset) const
+{
+    return base + ((offset - range.start) & mask);
+}
+
 Memory::Range::Range(uint16_t start, uint16_t end)
     : start(start)
     , end(end)
@@ -21,7 +36,7 @@ Memory::Range::Range(uint16_t start, uint16_t end)
 
 Memory::Range Memory::Range::fromBank(uint8_t bank, uint16_t bankSize)
 {
-    return Memory::Range(bank * bankSize, (bank + 1) * bankSize);
+    return Memory::Range(bank * bankSize, (bank + 1) * bankSize - 1);
 }
 
 bool Memory::Range::contains(uint16_t offset) const
@@ -29,54 +44,125 @@ bool Memory::Range::contains(uint16_t offset) const
     return offset >= start && offset <= end;
 }
 
-uint16_t Memory::Range::getGlobalOffset(uint16_t offset) const
+bool Memory::Range::contains(const Memory::Range& other) const
 {
-    return (start + offset) % (end - start);
+    return other.start >= start && other.end <= end;
+}
+
+bool Memory::Range::intersects(const Memory::Range& other) const
+{
+    return other.start <= end && other.end >= start;
 }
 
 
 Memory::Memory()
-    : _stackOffset(0)
+    : _nextHookId(0)
+    , _clock(nullptr)
+    , _stackOffset(0)
 {
+    memset(_hookedPages, 0x00, sizeof(_hookedPages));
+    unmountAll();
 }
 
 Memory::~Memory()
 {
 }
 
-uint8_t Memory::readByte(uint16_t offset) const
+uint8_t Memory::readMounted(uint16_t offset) const
 {
-    const auto mount = findMount(_readMounts, offset);
+    auto mount = _readPages[offset >> PAGE_SHIFT].mount;
     if (!mount)
     {
-        throw nes_memory_error("Mount point was not found for address " + offset);
+        mount = findMount(_readMounts, offset);
     }
 
-    return mount->accessor->readByte(offset - mount->range.start);
+    // Nothing drives the bus at unmapped addresses, so reads see open bus. It is approximated by the high
+    // byte of the address, the last value on the bus after an absolute operand fetch.
+    uint8_t value = offset >> 8;
+    if (mount)
+    {
+        value = readDevice(*mount, offset);
+    }
+
+    if (_hookedPages[offset >> PAGE_SHIFT] & MountMode::Read)
+    {
+        runHooks(MountMode::Read, offset, value);
+    }
+
+    return value;
 }
 
-void Memory::writeByte(uint16_t offset, uint8_t value)
+// Writes to unmapped addresses are dropped, but hooks still see them
+void Memory::writeMounted(uint16_t offset, uint8_t value)
 {
-    const auto mount = findMount(_writeMounts, offset);
+    auto mount = _writePages[offset >> PAGE_SHIFT].mount;
     if (!mount)
     {
-        throw nes_memory_error("Mount point was not found for address " + offset);
+        mount = findMount(_writeMounts, offset);
+    }
+    if (mount)
+    {
+        writeDevice(*mount, offset, value);
     }
 
-    mount->accessor->writeByte(offset - mount->range.start, value);
+    if (_hookedPages[offset >> PAGE_SHIFT] & MountMode::Write)
+    {
+        runHooks(MountMode::Write, offset, value);
+    }
 }
 
-uint8_t Memory::popByte(uint8_t &s)
+uint8_t Memory::readDevice(const Mount& mount, uint16_t offset) const
 {
-    s++;
-    return readByte(_stackOffset + s);
+    uint16_t local = mount.getLocalOffset(offset);
+    switch (mount.type)
+    {
+        case AccessorType::Buffer:
+        case AccessorType::RomBank:
+            return mount.data[mount.dataSize ? local % mount.dataSize : local];
+        case AccessorType::PPURegisters:
+            return static_cast<const PPURegistersAccessor*>(mount.accessor)->readByte(local);
+        case AccessorType::OamDma:
+            return static_cast<const OamDmaAccessor*>(mount.accessor)->readByte(local);
+        case AccessorType::MapperRegister:
+        case AccessorType::MMC1Register:
+        case AccessorType::MMC3Register:
+            return 0;
+        case AccessorType::Custom:
+            return mount.accessor->readByte(local);
+    }
+
+    return 0;
 }
 
-uint16_t Memory::readShort(uint16_t offset)
+void Memory::writeDevice(const Mount& mount, uint16_t offset, uint8_t value)
 {
-    uint8_t l = readByte(offset);
-    uint8_t h = readByte(offset + 1);
-    return l | (h << 8);
+    uint16_t local = mount.getLocalOffset(offset);
+    switch (mount.type)
+    {
+        case AccessorType::Buffer:
+            mount.data[mount.dataSize ? local % mount.dataSize : local] = value;
+            break;
+        case AccessorType::RomBank:
+            break;
+        case AccessorType::PPURegisters:
+            static_cast<PPURegistersAccessor*>(mount.accessor)->writeByte(local, value);
+            break;
+        case AccessorType::OamDma:
+            static_cast<OamDmaAccessor*>(mount.accessor)->writeByte(local, value);
+            break;
+        case AccessorType::MapperRegister:
+            mount.mapper->writeRegister(offset, value);
+            break;
+        case AccessorType::MMC1Register:
+            static_cast<MMC1*>(mount.mapper)->MMC1::writeRegister(offset, value);
+            break;
+        case AccessorType::MMC3Register:
+            static_cast<MMC3*>(mount.mapper)->MMC3::writeRegister(offset, value);
+            break;
+        case AccessorType::Custom:
+            mount.accessor->writeByte(local, value);
+            break;
+    }
 }
 
 uint16_t Memory::popShort(uint8_t &s)
@@ -92,12 +178,6 @@ void Memory::writeShort(uint16_t offset, uint16_t value)
     writeByte(offset + 1, value >> 8);
 }
 
-void Memory::pushByte(uint8_t &s, uint8_t value)
-{
-    writeByte(_stackOffset + s, value);
-    s--;
-}
-
 void Memory::pushShort(uint8_t &s, uint16_t value)
 {
     uint8_t l = value & 0xFF;
@@ -114,11 +194,29 @@ void Memory::readBytes(IMemoryAccessor* dst, uint16_t offset, uint16_t size)
     }
 }
 
-void Memory::readBytes(uint8_t *dst, uint16_t offset, uint16_t size)
+// Bulk transfers work page by page: pages backed by host memory are copied at once, device pages byte by byte.
+// Addresses wrap around at the end of the address space like they do on the bus.
+void Memory::readBytes(uint8_t *dst, uint16_t offset, uint32_t size)
 {
-    for (int i = offset; i < offset + size; ++i)
+    while (size > 0)
     {
-        *dst++ = readByte(i);
+        uint32_t chunk = std::min<uint32_t>(size, PAGE_SIZE - (offset & PAGE_MASK));
+        const Page& page = _readPages[offset >> PAGE_SHIFT];
+        if (page.data)
+        {
+            memcpy(dst, page.data + (offset & PAGE_MASK), chunk);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < chunk; ++i)
+            {
+                dst[i] = readMounted(offset + i);
+            }
+        }
+
+        dst += chunk;
+        offset += chunk;
+        size -= chunk;
     }
 }
 
@@ -130,6 +228,56 @@ void Memory::writeBytes(IMemoryAccessor* src, uint16_t offset, uint16_t size)
     }
 }
 
+void Memory::writeBytes(const uint8_t* src, uint16_t offset, uint32_t size)
+{
+    while (size > 0)
+    {
+        uint32_t chunk = std::min<uint32_t>(size, PAGE_SIZE - (offset & PAGE_MASK));
+        const Page& page = _writePages[offset >> PAGE_SHIFT];
+        if (page.data)
+        {
+            memcpy(page.data + (offset & PAGE_MASK), src, chunk);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < chunk; ++i)
+            {
+                writeMounted(offset + i, src[i]);
+            }
+        }
+
+        src += chunk;
+        offset += chunk;
+        size -= chunk;
+    }
+}
+
+void Memory::copyBytes(uint16_t dst, uint16_t src, uint32_t size)
+{
+    while (size > 0)
+    {
+        uint32_t chunk = std::min<uint32_t>(size, PAGE_SIZE - (src & PAGE_MASK));
+        chunk = std::min<uint32_t>(chunk, PAGE_SIZE - (dst & PAGE_MASK));
+        const Page& srcPage = _readPages[src >> PAGE_SHIFT];
+        const Page& dstPage = _writePages[dst >> PAGE_SHIFT];
+        if (srcPage.data && dstPage.data)
+        {
+            memmove(dstPage.data + (dst & PAGE_MASK), srcPage.data + (src & PAGE_MASK), chunk);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < chunk; ++i)
+            {
+                writeByte(dst + i, readByte(src + i));
+            }
+        }
+
+        src += chunk;
+        dst += chunk;
+        size -= chunk;
+    }
+}
+
 std::string Memory::readString(uint16_t offset)
 {
     char buffer[0x2000];
@@ -150,47 +298,277 @@ std::string Memory::readString(uint16_t offset)
 }
 
 void Memory::mount(Memory::Range range, IMemoryAccessor *accessor, MountMode mode)
+{
+    Mount custom(range, AccessorType::Custom);
+    custom.accessor = accessor;
+    mount(custom, mode);
+}
+
+void Memory::mount(Memory::Range range, PPURegistersAccessor* registers, MountMode mode)
+{
+    Mount device(range, AccessorType::PPURegisters);
+    device.accessor = registers;
+    mount(device, mode);
+}
+
+void Memory::mount(Memory::Range range, OamDmaAccessor* oamDma, MountMode mode)
+{
+    Mount device(range, AccessorType::OamDma);
+    device.accessor = oamDma;
+    mount(device, mode);
+}
+
+void Memory::mount(Memory::Range range, IRomMapper* mapper, MountMode mode)
+{
+    Mount registers(range, AccessorType::MapperRegister);
+    registers.mapper = mapper;
+    mount(registers, mode);
+}
+
+void Memory::mount(Memory::Range range, uint8_t* buffer, MountMode mode)
+{
+    mount(Mount(range, AccessorType::Buffer, buffer), mode);
+}
+
+// Mounts a buffer that repeats every size bytes over the range, so mirrors are resolved by the page table
+void Memory::mount(Memory::Range range, uint8_t* buffer, uint16_t size, MountMode mode)
+{
+    mount(Mount(range, AccessorType::Buffer, buffer, size), mode);
+}
+
+void Memory::mount(Memory::Range range, const INESRom::Bank* bank, Memory::MountMode mode)
+{
+    auto data = const_cast<uint8_t*>(bank->getData());
+    mount(Mount(range, AccessorType::RomBank, data, bank->getSize()), mode);
+}
+
+// Mirrors are resolved here: dst gets a copy of the mount currently behind src, so accesses never decode twice.
+// Remounting src later does not affect dst.
+void Memory::mirror(Memory::Range src, Memory::Range dst, MountMode mode)
 {
     if (mode & MountMode::Read)
     {
-        _readMounts.emplace_front(Mount(range, accessor));
+        mount(collapseMirror(_readMounts, src, dst), MountMode::Read);
     }
     if (mode & MountMode::Write)
     {
-        _writeMounts.emplace_front(Mount(range, accessor));
+        mount(collapseMirror(_writeMounts, src, dst), MountMode::Write);
     }
 }
 
-void Memory::mount(Memory::Range range, uint8_t* buffer, MountMode mode)
+Memory::Mount Memory::collapseMirror(const std::list<Memory::Mount>& source, Memory::Range src, Memory::Range dst) const
 {
-    auto accessor = std::make_shared<BufferAccessor>();
-    accessor->setBuffer(buffer);
-    mount(range, accessor.get(), mode);
+    auto target = findMount(source, src.start);
+    if (!target || !target->range.contains(src))
+    {
+        throw nes_memory_error("Mirror source has to be covered by a single mount");
+    }
+
+    // The copy would keep showing the bank that is mapped now, so switched memory cannot be mirrored
+    for (auto& window : _windows)
+    {
+        for (auto& page : window.pages)
+        {
+            if (page.mount == target)
+            {
+                throw nes_memory_error("Bank windows cannot be mirrored");
+            }
+        }
+    }
+
+    // A destination longer than the source repeats it, which takes a power of two sized source
+    uint32_t length = src.end - src.start + 1;
+    uint32_t dstLength = dst.end - dst.start + 1;
+    uint16_t mask = 0xFFFF;
+    if (dstLength > length)
+    {
+        if (length & (length - 1))
+        {
+            throw nes_memory_error("Repeated mirror source has to be a power of two long");
+        }
+        mask = length - 1;
+    }
+
+    uint16_t start = (src.start - target->range.start) & target->mask;
+    if (start + std::min(length, dstLength) - 1 > target->mask)
+    {
+        throw nes_memory_error("Mirror source wraps inside its mount");
+    }
 
-    _accessors.emplace_back(accessor);
+    Mount mirror = *target;
+    mirror.range = dst;
+    mirror.base = target->base + start;
+    mirror.mask = mask;
+    return mirror;
 }
 
-void Memory::mount(Memory::Range range, const INESRom::Bank* bank, Memory::MountMode mode)
+void Memory::unmountAll()
 {
-    auto accessor = std::make_shared<RomBankAccessor>(bank);
-    mount(range, accessor.get(), mode);
+    _readMounts.clear();
+    _writeMounts.clear();
+    _windows.clear();
 
-    _accessors.emplace_back(accessor);
+    memset(_readPages, 0x00, sizeof(_readPages));
+    memset(_writePages, 0x00, sizeof(_writePages));
 }
 
-void Memory::mirror(Memory::Range src, Memory::Range dst, MountMode mode)
+// Declares a window over range that is switched between range-sized banks of the given ROM banks.
+// Returns an id for switchBank, the window starts at bank 0.
+int Memory::addBankWindow(Memory::Range range, const std::vector<const INESRom::Bank*>& banks, MountMode mode)
 {
-    auto accessor = std::make_shared<MirrorAccessor>(this, src);
-    mount(dst, accessor.get(), mode);
+    std::vector<uint8_t*> source;
+    for (auto bank : banks)
+    {
+        auto data = const_cast<uint8_t*>(bank->getData());
+        for (uint32_t offset = 0; offset < bank->getSize(); offset += PAGE_SIZE)
+        {
+            source.push_back(data + offset);
+        }
+    }
 
-    _accessors.emplace_back(accessor);
+    return addBankWindow(range, AccessorType::RomBank, std::move(source), mode, 0);
 }
 
-void Memory::unmountAll()
+// Same as above for banked RAM, like CHR RAM or banked PRG RAM. If bankSize is set, banks are that large
+// and a shorter range only shows the start of each bank.
+int Memory::addBankWindow(Memory::Range range, uint8_t* buffer, uint32_t size, MountMode mode, uint32_t bankSize)
 {
-    _readMounts.clear();
-    _writeMounts.clear();
-    _accessors.clear();
+    std::vector<uint8_t*> source;
+    for (uint32_t offset = 0; offset < size; offset += PAGE_SIZE)
+    {
+        source.push_back(buffer + offset);
+    }
+
+    return addBankWindow(range, AccessorType::Buffer, std::move(source), mode, bankSize);
+}
+
+// Same as above with the buffer given page by page. A page can be listed several times, which mirrors RAM
+// smaller than a bank or lets one page stand in for a whole bank.
+int Memory::addBankWindow(Memory::Range range, const std::vector<uint8_t*>& pages, MountMode mode, uint32_t bankSize)
+{
+    return addBankWindow(range, AccessorType::Buffer, pages, mode, bankSize);
+}
+
+int Memory::addBankWindow(Memory::Range range, AccessorType type, std::vector<uint8_t*> source, MountMode mode,
+                          uint32_t bankSize)
+{
+    if ((range.start & PAGE_MASK) || (~range.end & PAGE_MASK) || (bankSize & PAGE_MASK))
+    {
+        throw nes_memory_error("Bank window has to be page aligned");
+    }
+
+    uint32_t pageCount = ((range.end - range.start) >> PAGE_SHIFT) + 1;
+    BankWindow window;
+    window.bankPages = bankSize ? bankSize >> PAGE_SHIFT : pageCount;
+    window.source = std::move(source);
+    if (window.bankPages < pageCount || window.source.size() < window.bankPages)
+    {
+        throw nes_memory_error("Bank window is larger than its banks");
+    }
+
+    for (uint32_t i = 0; i < pageCount; ++i)
+    {
+        int page = (range.start >> PAGE_SHIFT) + i;
+        auto pageStart = static_cast<uint16_t>(page << PAGE_SHIFT);
+        Mount mount(Range(pageStart, pageStart | PAGE_MASK), type);
+        if (mode & MountMode::Read)
+        {
+            _readMounts.emplace_front(mount);
+            _readPages[page].mount = &_readMounts.front();
+            window.pages.push_back({ &_readMounts.front(), _readPages, page, i });
+        }
+        if (mode & MountMode::Write)
+        {
+            _writeMounts.emplace_front(mount);
+            _writePages[page].mount = &_writeMounts.front();
+            window.pages.push_back({ &_writeMounts.front(), _writePages, page, i });
+        }
+    }
+
+    _windows.push_back(std::move(window));
+    int id = _windows.size() - 1;
+    switchBank(id, 0);
+    return id;
+}
+
+// Bank numbers past the end wrap around, like unconnected high bank bits on the cartridge
+void Memory::switchBank(int window, uint32_t bank)
+{
+    auto& bankWindow = _windows[window];
+    uint32_t first = bank * bankWindow.bankPages;
+    for (auto& windowPage : bankWindow.pages)
+    {
+        windowPage.mount->data = bankWindow.source[(first + windowPage.index) % bankWindow.source.size()];
+
+        // Pages that were mounted over later keep their newer mount
+        if (windowPage.pages[windowPage.page].mount == windowPage.mount)
+        {
+            mapPage(*windowPage.mount, windowPage.pages, windowPage.page);
+        }
+    }
+}
+
+// Hooks are tracked per page: a hooked page loses its host memory pointer, so only accesses to it take the
+// slow path and check the hook ranges. Returns an id for removeHook.
+int Memory::addHook(Memory::Range range, Memory::Hook hook, MountMode mode)
+{
+    _hooks.push_back({ _nextHookId, range, mode, hook });
+    updateHookedPages();
+    return _nextHookId++;
+}
+
+void Memory::removeHook(int id)
+{
+    _hooks.remove_if([id](const HookEntry& entry) { return entry.id == id; });
+    updateHookedPages();
+}
+
+// Hooks are called with the value of cycle at the time of the access
+void Memory::setClock(const uint64_t* cycle)
+{
+    _clock = cycle;
+}
+
+void Memory::updateHookedPages()
+{
+    uint8_t hooked[PAGE_COUNT] = {};
+    for (auto& entry : _hooks)
+    {
+        for (int page = entry.range.start >> PAGE_SHIFT; page <= entry.range.end >> PAGE_SHIFT; ++page)
+        {
+            hooked[page] |= entry.mode;
+        }
+    }
+
+    for (int page = 0; page < PAGE_COUNT; ++page)
+    {
+        if (hooked[page] == _hookedPages[page])
+        {
+            continue;
+        }
+
+        _hookedPages[page] = hooked[page];
+        if (_readPages[page].mount)
+        {
+            mapPage(*_readPages[page].mount, _readPages, page);
+        }
+        if (_writePages[page].mount)
+        {
+            mapPage(*_writePages[page].mount, _writePages, page);
+        }
+    }
+}
+
+void Memory::runHooks(MountMode mode, uint16_t offset, uint8_t value) const
+{
+    uint64_t cycle = _clock ? *_clock : 0;
+    for (auto& entry : _hooks)
+    {
+        if ((entry.mode & mode) && entry.range.contains(offset))
+        {
+            entry.hook(offset, value, cycle);
+        }
+    }
 }
 
 void Memory::setStackOffset(uint16_t offset)
@@ -198,6 +576,72 @@ void Memory::setStackOffset(uint16_t offset)
     _stackOffset = offset;
 }
 
+void Memory::mount(const Memory::Mount& mount, MountMode mode)
+{
+    if (mode & MountMode::Read)
+    {
+        _readMounts.emplace_front(mount);
+        mapPages(_readMounts.front(), _readPages);
+    }
+    if (mode & MountMode::Write)
+    {
+        _writeMounts.emplace_front(mount);
+        mapPages(_writeMounts.front(), _writePages);
+    }
+}
+
+void Memory::mapPages(const Memory::Mount& mount, Memory::Page* pages)
+{
+    // The newest mount always takes precedence, so only the pages it touches have to be decoded again.
+    for (int page = mount.range.start >> PAGE_SHIFT; page <= mount.range.end >> PAGE_SHIFT; ++page)
+    {
+        auto pageStart = static_cast<uint16_t>(page << PAGE_SHIFT);
+        if (!mount.range.contains(Range(pageStart, pageStart | PAGE_MASK)))
+        {
+            pages[page].data = nullptr;
+            pages[page].mount = nullptr;
+            continue;
+        }
+
+        mapPage(mount, pages, page);
+    }
+}
+
+// Decodes a page that is fully covered by mount
+void Memory::mapPage(const Memory::Mount& mount, Memory::Page* pages, int page)
+{
+    pages[page].mount = &mount;
+    pages[page].data = nullptr;
+    if (!mount.data || (pages == _writePages && mount.type == AccessorType::RomBank))
+    {
+        return;
+    }
+    if (_hookedPages[page] & (pages == _writePages ? MountMode::Write : MountMode::Read))
+    {
+        return;
+    }
+
+    // The page has to be contiguous in the device, so it must not wrap around the mask
+    auto pageStart = static_cast<uint16_t>(page << PAGE_SHIFT);
+    uint16_t masked = (pageStart - mount.range.start) & mount.mask;
+    if (masked + PAGE_MASK > mount.mask)
+    {
+        return;
+    }
+
+    uint32_t local = mount.base + masked;
+    if (mount.dataSize > 0)
+    {
+        local %= mount.dataSize;
+        if (local + PAGE_SIZE > mount.dataSize)
+        {
+            return;
+        }
+    }
+
+    pages[page].data = mount.data + local;
+}
+
 const Memory::Mount* Memory::findMount(const std::list<Mount>& source, uint16_t offset) const
 {
     for (auto& mount : source)
@@ -6,12 +6,18 @@
 #include <list>
 #include <memory>
 #include <stdexcept>
+#include <functional>
+#include <vector>
 #include "accessors/IMemoryAccessor.h"
 #include "../rom/INESRom.h"
 
 namespace nescore
 {
 
+class PPURegistersAccessor;
+class OamDmaAccessor;
+class IRomMapper;
+
 class nes_memory_error : std::runtime_error
 {
 public:
@@ -23,6 +29,11 @@ public:
 class Memory : public IMemoryAccessor
 {
 public:
+    static const uint16_t PAGE_SHIFT = 8;
+    static const uint16_t PAGE_SIZE = 1 << PAGE_SHIFT;
+    static const uint16_t PAGE_MASK = PAGE_SIZE - 1;
+    static const uint16_t PAGE_COUNT = 0x10000 >> PAGE_SHIFT;
+
     enum MountMode
     {
         Read = 0b01,
@@ -40,17 +51,57 @@ public:
         Range(uint16_t start, uint16_t end);
 
         bool contains(uint16_t offset) const;
-        uint16_t getGlobalOffset(uint16_t offset) const;
+        bool contains(const Range& other) const;
+        bool intersects(const Range& other) const;
     };
 
+    // Kinds of devices a mount can point to. Everything except Custom is dispatched with a switch, so
+    // plain memory and the fixed set of NES devices never go through a virtual call.
+    // MapperRegister calls IRomMapper virtually; common mappers have their own type, see mountMapper.
+    enum AccessorType
+    {
+        Custom,
+        Buffer,
+        RomBank,
+        PPURegisters,
+        OamDma,
+        MapperRegister,
+        MMC1Register,
+        MMC3Register
+    };
+
+    // An address inside range reaches the device at base + ((address - range.start) & mask).
+    // Buffer and RomBank mounts are served from data, repeating every dataSize bytes if it is set.
+    // The others use accessor or mapper.
     struct Mount
     {
         Range range;
+        AccessorType type;
         IMemoryAccessor* accessor;
+        IRomMapper* mapper;
+        uint8_t* data;
+        uint32_t dataSize;
+        uint16_t base;
+        uint16_t mask;
+
+        Mount(Range range, AccessorType type, uint8_t* data = nullptr, uint32_t dataSize = 0);
 
-        Mount(Range, IMemoryAccessor* accessor);
+        uint16_t getLocalOffset(uint16_t offset) const;
     };
 
+    // Decoded view of a single page. If the page is backed by plain host memory,
+    // data points to the first byte of the page. Otherwise, if a single mount covers
+    // the whole page, mount is set. Pages with neither go through the mount list.
+    // Hooked pages never get data, so unhooked pages keep the single-branch fast path.
+    struct Page
+    {
+        uint8_t* data;
+        const Mount* mount;
+    };
+
+    // Called after every access to a hooked address with the address, the value read or written and the clock.
+    using Hook = std::function<void(uint16_t address, uint8_t value, uint64_t cycle)>;
+
 public:
     Memory();
     virtual ~Memory();
@@ -66,29 +117,155 @@ public:
     void pushByte(uint8_t& s, uint8_t value);
     void pushShort(uint8_t& s, uint16_t value);
     void readBytes(IMemoryAccessor* dst, uint16_t offset, uint16_t size);
-    void readBytes(uint8_t* dst, uint16_t offset, uint16_t size);
+    void readBytes(uint8_t* dst, uint16_t offset, uint32_t size);
     void writeBytes(IMemoryAccessor* src, uint16_t offset, uint16_t size);
+    void writeBytes(const uint8_t* src, uint16_t offset, uint32_t size);
+    void copyBytes(uint16_t dst, uint16_t src, uint32_t size);
     void setStackOffset(uint16_t offset);
 
     std::string readString(uint16_t offset);
+    const uint8_t* getReadOnlyPage(uint16_t offset) const;
+    bool isDirect(uint16_t offset) const;
 
     void mount(Range range, IMemoryAccessor* accessor, MountMode mode = MountMode::ReadWrite);
+    void mount(Range range, PPURegistersAccessor* registers, MountMode mode = MountMode::ReadWrite);
+    void mount(Range range, OamDmaAccessor* oamDma, MountMode mode = MountMode::ReadWrite);
+    void mount(Range range, IRomMapper* mapper, MountMode mode = MountMode::Write);
+    template <typename Mapper> void mountMapper(Range range, Mapper* mapper, MountMode mode = MountMode::Write);
     void mount(Range range, uint8_t* buffer, MountMode mode = MountMode::ReadWrite);
+    void mount(Range range, uint8_t* buffer, uint16_t size, MountMode mode = MountMode::ReadWrite);
     void mount(Range range, const INESRom::Bank* bank, MountMode mode = MountMode::ReadWrite);
     void mirror(Range src, Range dst, MountMode mode = MountMode::ReadWrite);
     void unmountAll();
 
+    int addBankWindow(Range range, const std::vector<const INESRom::Bank*>& banks, MountMode mode = MountMode::Read);
+    int addBankWindow(Range range, uint8_t* buffer, uint32_t size, MountMode mode = MountMode::ReadWrite,
+                      uint32_t bankSize = 0);
+    int addBankWindow(Range range, const std::vector<uint8_t*>& pages, MountMode mode, uint32_t bankSize);
+    void switchBank(int window, uint32_t bank);
+
+    int addHook(Range range, Hook hook, MountMode mode = MountMode::Write);
+    void removeHook(int id);
+    void setClock(const uint64_t* cycle);
+
 private:
+    struct HookEntry
+    {
+        int id;
+        Range range;
+        MountMode mode;
+        Hook hook;
+    };
+
+    struct WindowPage
+    {
+        Mount* mount;
+        Page* pages;
+        int page;
+        uint32_t index;
+    };
+
+    // A fixed range that shows one bank-sized slice of source at a time. Every page of the window
+    // has its own mount, so switching banks only repoints those mounts and their page entries.
+    struct BankWindow
+    {
+        std::vector<uint8_t*> source;
+        std::vector<WindowPage> pages;
+        uint32_t bankPages;
+    };
+
+    void mount(const Mount& mount, MountMode mode);
+    Mount collapseMirror(const std::list<Mount>& source, Range src, Range dst) const;
+    void mapPages(const Mount& mount, Page* pages);
+    void mapPage(const Mount& mount, Page* pages, int page);
+    int addBankWindow(Range range, AccessorType type, std::vector<uint8_t*> source, MountMode mode, uint32_t bankSize);
+    void updateHookedPages();
+    void runHooks(MountMode mode, uint16_t offset, uint8_t value) const;
+    uint8_t readMounted(uint16_t offset) const;
+    void writeMounted(uint16_t offset, uint8_t value);
+    uint8_t readDevice(const Mount& mount, uint16_t offset) const;
+    void writeDevice(const Mount& mount, uint16_t offset, uint8_t value);
     const Mount* findMount(const std::list<Mount>& source, uint16_t offset) const;
 
 private:
     std::list<Mount> _readMounts;
     std::list<Mount> _writeMounts;
-    std::list<std::shared_ptr<IMemoryAccessor>> _accessors;
+    Page _readPages[PAGE_COUNT];
+    Page _writePages[PAGE_COUNT];
+    uint8_t _hookedPages[PAGE_COUNT];
+    std::vector<BankWindow> _windows;
+    std::list<HookEntry> _hooks;
+    int _nextHookId;
+    const uint64_t* _clock;
     uint16_t _stackOffset;
 
 };
 
+inline uint8_t Memory::readByte(uint16_t offset) const
+{
+    const Page& page = _readPages[offset >> PAGE_SHIFT];
+    if (page.data)
+    {
+        return page.data[offset & PAGE_MASK];
+    }
+
+    return readMounted(offset);
+}
+
+inline void Memory::writeByte(uint16_t offset, uint8_t value)
+{
+    const Page& page = _writePages[offset >> PAGE_SHIFT];
+    if (page.data)
+    {
+        page.data[offset & PAGE_MASK] = value;
+        return;
+    }
+
+    writeMounted(offset, value);
+}
+
+// Returns host memory of the page containing offset if it can only be changed by remapping (ROM)
+inline const uint8_t* Memory::getReadOnlyPage(uint16_t offset) const
+{
+    auto page = offset >> PAGE_SHIFT;
+    return _writePages[page].data || (_hookedPages[page] & MountMode::Write) ? nullptr : _readPages[page].data;
+}
+
+// True if reads of offset go straight to host memory, so its value can only change through a CPU write
+inline bool Memory::isDirect(uint16_t offset) const
+{
+    return _readPages[offset >> PAGE_SHIFT].data != nullptr;
+}
+
+// Mounts the registers of a final mapper class tagged with its own ACCESSOR_TYPE. Writes to them are
+// switched on that tag and call Mapper::writeRegister directly, without any indirect call.
+template <typename Mapper>
+void Memory::mountMapper(Range range, Mapper* mapper, MountMode mode)
+{
+    Mount registers(range, Mapper::ACCESSOR_TYPE);
+    registers.mapper = mapper;
+    mount(registers, mode);
+}
+
+inline uint16_t Memory::readShort(uint16_t offset)
+{
+    uint8_t l = Memory::readByte(offset);
+    uint8_t h = Memory::readByte(offset + 1);
+    return l | (h << 8);
+}
+
+inline uint8_t Memory::popByte(uint8_t &s)
+{
+    s++;
+    return Memory::readByte(_stackOffset + s);
+}
+
+inline void Memory::pushByte(uint8_t &s, uint8_t value)
+{
+    Memory::writeByte(_stackOffset + s, value);
+    s--;
+}
+
 }
 
 #endif //NESCORE_MEMORY_H
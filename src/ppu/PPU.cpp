@@ -3,6 +3,7 @@
 #include "PPUMemory.h"
 #include "../cpu/CPU.h"
 #include "../cpu/CPUMemory.h"
+#include "../mappers/IRomMapper.h"
 
 namespace nescore
 {
@@ -24,6 +25,14 @@ std::shared_ptr<PPUMemory> PPU::getMemory()
     return _memory;
 }
 
+// Plugs the cartridge into the PPU bus and keeps it informed about rendering, which drives scanline counters
+void PPU::setMapper(std::shared_ptr<IRomMapper> mapper)
+{
+    _mapper = mapper;
+    _mapper->setupPPU(_memory);
+    _mapper->setRendering(_ppuMask.getShowBackground() || _ppuMask.getShowSprites());
+}
+
 void PPU::setPPUControl(uint8_t value)
 {
     _ppuControl = value;
@@ -31,7 +40,12 @@ void PPU::setPPUControl(uint8_t value)
 
 void PPU::setPPUMask(uint8_t value)
 {
+    bool rendering = _ppuMask.getShowBackground() || _ppuMask.getShowSprites();
     _ppuMask = value;
+    if (_mapper && rendering != (_ppuMask.getShowBackground() || _ppuMask.getShowSprites()))
+    {
+        _mapper->setRendering(!rendering);
+    }
 }
 
 void PPU::setPPUStatus(uint8_t value)
@@ -66,7 +80,10 @@ void PPU::setPPUData(uint8_t value)
 
 void PPU::setOamDma(uint8_t value)
 {
-    _cpu->getMemory()->readBytes(&_oam[_oamAddr], value << 8, 0xFF);
+    // All 256 bytes of the page are written, starting at OAMADDR and wrapping around
+    auto memory = _cpu->getMemory();
+    memory->readBytes(&_oam[_oamAddr], value << 8, sizeof(_oam) - _oamAddr);
+    memory->readBytes(_oam, (value << 8) + sizeof(_oam) - _oamAddr, _oamAddr);
     _cpu->startDmaTransfer();
 }
 
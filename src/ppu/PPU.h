@@ -15,6 +15,7 @@ namespace nescore
 
 class CPU;
 class PPUMemory;
+class IRomMapper;
 
 class PPU
 {
@@ -22,6 +23,7 @@ public:
     PPU(std::shared_ptr<CPU> cpu);
 
     std::shared_ptr<PPUMemory> getMemory();
+    void setMapper(std::shared_ptr<IRomMapper> mapper);
 
     void setPPUControl(uint8_t value);
     void setPPUMask(uint8_t value);
@@ -43,6 +45,7 @@ public:
 private:
     std::shared_ptr<CPU> _cpu;
     std::shared_ptr<PPUMemory> _memory;
+    std::shared_ptr<IRomMapper> _mapper;
 
     PPURegistersAccessor _registers;
     OamDmaAccessor _oamDma;
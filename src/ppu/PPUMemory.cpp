@@ -1,19 +1,27 @@
 #include <memory.h>
+#include <algorithm>
 #include "PPUMemory.h"
 
 namespace nescore
 {
 
 const Memory::Range PPUMemory::VRAM = Memory::Range(0x2000, 0x2FFF);
-const Memory::Range PPUMemory::VRAM_MIRROR = Memory::Range(0x3000, 0x2EFF);
+const Memory::Range PPUMemory::VRAM_MIRROR = Memory::Range(0x3000, 0x3EFF);
 
+// Every nametable and its mirror is a bank window over VRAM, so changing the mirroring only repoints pages.
+// Until setMirroring is called the four nametables are separate, like with four-screen VRAM.
 PPUMemory::PPUMemory()
-    : _vram(new uint8_t[0x2000])
+    : _vram(new uint8_t[0x1000])
 {
-    mount(VRAM, _vram);
-    mirror(VRAM, VRAM_MIRROR);
+    memset(_vram, 0x00, sizeof(uint8_t) * 0x1000);
 
-    memset(_vram, 0x00, sizeof(uint8_t) * 0x2000);
+    for (int i = 0; i < 8; ++i)
+    {
+        uint16_t start = VRAM.start + i * NAMETABLE_SIZE;
+        uint16_t end = std::min<uint16_t>(start + NAMETABLE_SIZE - 1, VRAM_MIRROR.end);
+        _nametables[i] = addBankWindow(Memory::Range(start, end), _vram, 0x1000, MountMode::ReadWrite, NAMETABLE_SIZE);
+        switchBank(_nametables[i], i % 4);
+    }
 }
 
 PPUMemory::~PPUMemory()
@@ -21,4 +29,27 @@ PPUMemory::~PPUMemory()
     delete[] _vram;
 }
 
-}
\ No newline at end of file
+void PPUMemory::setMirroring(INESRom::Mirroring mirroring)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        int nametable = i % 4;
+        switch (mirroring)
+        {
+            case INESRom::HORIZONTAL:
+                switchBank(_nametables[i], nametable >> 1);
+                break;
+            case INESRom::VERTICAL:
+                switchBank(_nametables[i], nametable & 1);
+                break;
+            case INESRom::SINGLE_SCREEN_LOWER:
+                switchBank(_nametables[i], 0);
+                break;
+            case INESRom::SINGLE_SCREEN_UPPER:
+                switchBank(_nametables[i], 1);
+                break;
+        }
+    }
+}
+
+}
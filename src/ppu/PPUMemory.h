@@ -2,6 +2,7 @@
 #define NESCORE_PPUMEMORY_H
 
 #include "../memory/Memory.h"
+#include "../rom/INESRom.h"
 
 namespace nescore
 {
@@ -11,13 +12,17 @@ class PPUMemory : public Memory
 public:
     static const Memory::Range VRAM;
     static const Memory::Range VRAM_MIRROR;
+    static const uint16_t NAMETABLE_SIZE = 0x400;
 
 public:
     PPUMemory();
     ~PPUMemory();
 
+    void setMirroring(INESRom::Mirroring mirroring);
+
 private:
     uint8_t* _vram;
+    int _nametables[8];
 };
 
 }
@@ -8,7 +8,7 @@ namespace nescore
 
 class PPU;
 
-class OamDmaAccessor : public IMemoryAccessor
+class OamDmaAccessor final : public IMemoryAccessor
 {
 private:
     static const Memory::Range ADDRESS;
@@ -11,14 +11,14 @@ class PPUMask
 private:
     enum Bits
     {
-        GRAYSCALE = 0x00000001,
-        SHOW_LEFT_BACKGROUND = 0x00000010,
-        SHOW_LEFT_SPRITES = 0x00000100,
-        SHOW_BACKGROUND = 0x0001000,
-        SHOW_SPRITES = 0x00010000,
-        EMPHASIZE_RED = 0x00100000,
-        EMPHASIZE_GREEN = 0x01000000,
-        EMPHASIZE_BLUE = 0x10000000,
+        GRAYSCALE = 0b00000001,
+        SHOW_LEFT_BACKGROUND = 0b00000010,
+        SHOW_LEFT_SPRITES = 0b00000100,
+        SHOW_BACKGROUND = 0b00001000,
+        SHOW_SPRITES = 0b00010000,
+        EMPHASIZE_RED = 0b00100000,
+        EMPHASIZE_GREEN = 0b01000000,
+        EMPHASIZE_BLUE = 0b10000000,
     };
 
 public:
@@ -9,7 +9,7 @@ namespace nescore
 
 class PPU;
 
-class PPURegistersAccessor : public IMemoryAccessor
+class PPURegistersAccessor final : public IMemoryAccessor
 {
 private:
     static const Memory::Range RANGE;
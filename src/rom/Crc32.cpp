@@ -0,0 +1,164 @@
+#include "Crc32.h"
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define NESCORE_CRC32_PCLMUL
+#endif
+
+namespace nescore
+{
+
+namespace
+{
+
+// entries[k][i] is the CRC of byte i followed by k zero bytes, so eight bytes are folded per step
+struct Table
+{
+    uint32_t entries[8][0x100];
+
+    Table()
+    {
+        for (uint32_t i = 0; i < 0x100; ++i)
+        {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+            }
+            entries[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 0x100; ++i)
+        {
+            for (int k = 1; k < 8; ++k)
+            {
+                entries[k][i] = entries[0][entries[k - 1][i] & 0xFF] ^ (entries[k - 1][i] >> 8);
+            }
+        }
+    }
+};
+
+const Table TABLE;
+
+// Works on the inverted CRC
+uint32_t updatePortable(const uint8_t* data, size_t size, uint32_t crc)
+{
+    for (; size >= 8; data += 8, size -= 8)
+    {
+        uint32_t low, high;
+        memcpy(&low, data, 4);
+        memcpy(&high, data + 4, 4);
+        low ^= crc;
+        crc = TABLE.entries[7][low & 0xFF] ^ TABLE.entries[6][(low >> 8) & 0xFF] ^
+              TABLE.entries[5][(low >> 16) & 0xFF] ^ TABLE.entries[4][low >> 24] ^
+              TABLE.entries[3][high & 0xFF] ^ TABLE.entries[2][(high >> 8) & 0xFF] ^
+              TABLE.entries[1][(high >> 16) & 0xFF] ^ TABLE.entries[0][high >> 24];
+    }
+    for (; size > 0; ++data, --size)
+    {
+        crc = TABLE.entries[0][(crc ^ *data) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+#ifdef NESCORE_CRC32_PCLMUL
+
+__attribute__((target("pclmul,sse4.1")))
+inline __m128i load(const uint8_t* data)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+// Multiplies both halves of x by their constant in k, which moves x 128 (or 512) bits forward, onto next
+__attribute__((target("pclmul,sse4.1")))
+inline __m128i fold(__m128i x, __m128i k, __m128i next)
+{
+    return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11)), next);
+}
+
+// Carry-less multiplication folding (Intel, "Fast CRC Computation Using PCLMULQDQ"). Folds four
+// 16-byte lanes per 64-byte step, then one lane, then reduces to 32 bits with Barrett reduction.
+// Works on the inverted CRC; size has to be a multiple of 16 and at least 64.
+__attribute__((target("pclmul,sse4.1")))
+uint32_t updateFolded(const uint8_t* data, size_t size, uint32_t crc)
+{
+    const __m128i k1k2 = _mm_set_epi64x(0x01C6E41596, 0x0154442BD4);
+    const __m128i k3k4 = _mm_set_epi64x(0x00CCAA009E, 0x01751997D0);
+    const __m128i k5 = _mm_set_epi64x(0, 0x0163CD6124);
+    const __m128i poly = _mm_set_epi64x(0x01F7011641, 0x01DB710641);
+    const __m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+
+    __m128i x1 = _mm_xor_si128(load(data), _mm_cvtsi32_si128(crc));
+    __m128i x2 = load(data + 0x10);
+    __m128i x3 = load(data + 0x20);
+    __m128i x4 = load(data + 0x30);
+    data += 64;
+    size -= 64;
+
+    for (; size >= 64; data += 64, size -= 64)
+    {
+        x1 = fold(x1, k1k2, load(data));
+        x2 = fold(x2, k1k2, load(data + 0x10));
+        x3 = fold(x3, k1k2, load(data + 0x20));
+        x4 = fold(x4, k1k2, load(data + 0x30));
+    }
+
+    x1 = fold(x1, k3k4, x2);
+    x1 = fold(x1, k3k4, x3);
+    x1 = fold(x1, k3k4, x4);
+    for (; size >= 16; data += 16, size -= 16)
+    {
+        x1 = fold(x1, k3k4, load(data));
+    }
+
+    // 128 to 64 bits
+    x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask), k5, 0x00), x2);
+
+    // Barrett reduction to 32 bits
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), poly, 0x10);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask), poly, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return _mm_extract_epi32(x1, 1);
+}
+
+bool hasPclmul()
+{
+    unsigned int eax, ebx, ecx, edx;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_PCLMUL) && (ecx & bit_SSE4_1);
+}
+
+const bool HAS_PCLMUL = hasPclmul();
+
+#endif
+
+}
+
+// crc continues a previous result, so data can be hashed in pieces.
+// Uses PCLMULQDQ folding on CPUs that have it and slicing-by-8 tables otherwise.
+uint32_t Crc32::compute(const uint8_t* data, size_t size, uint32_t crc)
+{
+    crc = ~crc;
+#ifdef NESCORE_CRC32_PCLMUL
+    if (HAS_PCLMUL && size >= 64)
+    {
+        size_t folded = size & ~size_t(15);
+        crc = updateFolded(data, folded, crc);
+        data += folded;
+        size -= folded;
+    }
+#endif
+
+    return ~updatePortable(data, size, crc);
+}
+
+// Same as compute but always uses the portable tables, for checking the fast path
+uint32_t Crc32::computePortable(const uint8_t* data, size_t size, uint32_t crc)
+{
+    return ~updatePortable(data, size, ~crc);
+}
+
+}
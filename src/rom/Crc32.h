@@ -0,0 +1,20 @@
+#ifndef NESCORE_CRC32_H
+#define NESCORE_CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nescore
+{
+
+// CRC-32 as used by ROM databases (IEEE 802.3, reflected, polynomial 0xEDB88320)
+class Crc32
+{
+public:
+    static uint32_t compute(const uint8_t* data, size_t size, uint32_t crc = 0);
+    static uint32_t computePortable(const uint8_t* data, size_t size, uint32_t crc = 0);
+};
+
+}
+
+#endif //NESCORE_CRC32_H
@@ -1,5 +1,10 @@
 #include <memory.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "INESRom.h"
+#include "Crc32.h"
 
 namespace nescore
 {
@@ -7,6 +12,7 @@ namespace nescore
 INESRom::Bank::Bank(uint16_t size)
     : _size(size)
     , _data(nullptr)
+    , _owned(false)
 {
 }
 
@@ -14,6 +20,7 @@ INESRom::Bank::Bank(INESRom::Bank &&other)
 {
     _size = other._size;
     _data = other._data;
+    _owned = other._owned;
     other._data = nullptr;
 }
 
@@ -27,20 +34,37 @@ uint16_t INESRom::Bank::getSize() const
     return _size;
 }
 
+const uint8_t* INESRom::Bank::getData() const
+{
+    return _data;
+}
+
 void INESRom::Bank::read(std::istream &stream)
 {
     clear();
 
     _data = new uint8_t[_size];
+    _owned = true;
     stream.read(reinterpret_cast<char*>(_data), _size);
 }
 
+// Makes the bank a view of data, which has to outlive it
+void INESRom::Bank::view(const uint8_t* data)
+{
+    clear();
+
+    _data = const_cast<uint8_t*>(data);
+    _owned = false;
+}
+
 void INESRom::Bank::clear()
 {
-    if (_data) delete[] _data;
+    if (_owned) delete[] _data;
+    _data = nullptr;
+    _owned = false;
 }
 
-void INESRom::Bank::writeByte(uint16_t offset, uint8_t value)
+void INESRom::Bank::writeByte(uint16_t /* offset */, uint8_t /* value */)
 {
 }
 
@@ -50,10 +74,24 @@ uint8_t INESRom::Bank::readByte(uint16_t offset) const
 }
 
 const char INESRom::FORMAT[] = { 0x4E, 0x45, 0x53, 0x1A };
+const uint16_t INESRom::HEADER_SIZE;
+const uint16_t INESRom::TRAINER_SIZE;
+const uint16_t INESRom::PRG_ROM_BANK_SIZE;
+const uint16_t INESRom::CHR_ROM_BANK_SIZE;
+const uint16_t INESRom::PLAY_CHOICE_10_SIZE;
+const uint16_t INESRom::PRG_RAM_BANK_SIZE;
+const size_t INESRom::DATA_ALIGNMENT;
+const uint64_t INESRom::HASHED;
 
 INESRom::INESRom()
-    : _trainer(TRAINER_SIZE)
+    : _arena(nullptr)
+    , _data(nullptr)
+    , _mapping(nullptr)
+    , _mappingSize(0)
+    , _trainer(TRAINER_SIZE)
     , _playChoice10(PLAY_CHOICE_10_SIZE)
+    , _prgHash(0)
+    , _chrHash(0)
 {
     memset(&_header, 0x00, sizeof(INESHeader));
 }
@@ -67,59 +105,180 @@ void INESRom::read(std::istream &stream)
 {
     clear();
 
-    stream.read(reinterpret_cast<char*>(&_header.fileFormat), 4);
-    if (memcmp(_header.fileFormat, FORMAT, 4) != 0)
+    uint8_t header[HEADER_SIZE];
+    stream.read(reinterpret_cast<char*>(header), HEADER_SIZE);
+    decodeHeader(header, stream.gcount());
+
+    // All banks live in one aligned arena, in file order
+    size_t size = getDataSize();
+    _arena = new uint8_t[size + DATA_ALIGNMENT]();
+    auto address = reinterpret_cast<uintptr_t>(_arena);
+    auto data = _arena + ((DATA_ALIGNMENT - address % DATA_ALIGNMENT) % DATA_ALIGNMENT);
+    stream.read(reinterpret_cast<char*>(data), size);
+    if (static_cast<size_t>(stream.gcount()) != size)
+    {
+        clear();
+        throw nesformat_error("ROM image is truncated");
+    }
+
+    viewBanks(data, size);
+}
+
+// Maps the file read-only, so all instances loading the same ROM share the page cache copy of it
+void INESRom::load(const std::string& fileName)
+{
+    clear();
+
+    int file = open(fileName.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        throw nesformat_error("Unable to open " + fileName);
+    }
+
+    struct stat info;
+    void* mapping = MAP_FAILED;
+    if (fstat(file, &info) == 0 && info.st_size > 0)
+    {
+        mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, file, 0);
+    }
+    close(file);
+    if (mapping == MAP_FAILED)
+    {
+        throw nesformat_error("Unable to map " + fileName);
+    }
+
+    try
+    {
+        parse(static_cast<const uint8_t*>(mapping), info.st_size);
+    }
+    catch (...)
+    {
+        munmap(mapping, info.st_size);
+        throw;
+    }
+    _mapping = static_cast<const uint8_t*>(mapping);
+    _mappingSize = info.st_size;
+}
+
+// Parses an image that is already in memory. Banks become views into data, which has to outlive the ROM
+// or the next load. Throws nesformat_error if the header is invalid or the image is shorter than it declares.
+void INESRom::parse(const uint8_t* data, size_t size)
+{
+    clear();
+
+    decodeHeader(data, size);
+    viewBanks(data + HEADER_SIZE, size - HEADER_SIZE);
+}
+
+void INESRom::decodeHeader(const uint8_t* data, size_t size)
+{
+    if (size < HEADER_SIZE)
+    {
+        throw nesformat_error("ROM image is shorter than its header");
+    }
+    if (memcmp(data, FORMAT, 4) != 0)
     {
         throw nesformat_error("Invalid ROM format type");
     }
+    memcpy(&_header, data, sizeof(INESHeader));
 
-    stream >> _header.prgRomBanks;
-    stream >> _header.chrRomBanks;
-    stream >> _header.flag6;
-    stream >> _header.flag7;
-    stream >> _header.prgRamBanks;
-    stream >> _header.flag9;
-    stream.ignore(6);
+    // Old dumping tools signed their name over bytes 7-15, which leaves garbage in the upper mapper nibble
+    if (!isNES2Format() && (data[12] | data[13] | data[14] | data[15]))
+    {
+        _header.flag7 &= ~Flag7::MAPPER_UPPER;
+    }
+    if (isNES2Format() && ((_header.flag9 & Flag9::PRG_ROM_BANKS_UPPER) == 0x0F ||
+                           (_header.flag9 & Flag9::CHR_ROM_BANKS_UPPER) == 0xF0))
+    {
+        throw nesformat_error("ROM sizes in exponent notation are not supported");
+    }
+    if (getPrgRomBanks() == 0)
+    {
+        throw nesformat_error("ROM has no PRG ROM");
+    }
+}
 
+// Points all banks into data, which holds everything that follows the header
+void INESRom::viewBanks(const uint8_t* data, size_t size)
+{
+    if (size < getDataSize())
+    {
+        throw nesformat_error("ROM image is truncated");
+    }
+
+    _data = data;
+    size_t offset = 0;
     if (hasTrainer())
     {
-        stream >> _trainer;
+        _trainer.view(data);
+        offset += TRAINER_SIZE;
     }
 
-    for (int i = 0; i < _header.prgRomBanks; ++i)
+    _prgRoms.reserve(getPrgRomBanks());
+    for (int i = 0; i < getPrgRomBanks(); ++i)
     {
-        auto bank = new Bank(PRG_ROM_BANK_SIZE);
-        stream >> *bank;
-        _prgRoms.push_back(bank);
+        _prgRoms.emplace_back(PRG_ROM_BANK_SIZE);
+        _prgRoms.back().view(data + offset);
+        offset += PRG_ROM_BANK_SIZE;
     }
 
-    for (int i = 0; i < _header.chrRomBanks; ++i)
+    _chrRoms.reserve(getChrRomBanks());
+    for (int i = 0; i < getChrRomBanks(); ++i)
     {
-        auto bank = new Bank(CHR_ROM_BANK_SIZE);
-        stream >> *bank;
-        _chrRoms.push_back(bank);
+        _chrRoms.emplace_back(CHR_ROM_BANK_SIZE);
+        _chrRoms.back().view(data + offset);
+        offset += CHR_ROM_BANK_SIZE;
     }
 
     if (hasPlayChoice10())
     {
-        stream >> _playChoice10;
+        _playChoice10.view(data + offset);
     }
 }
 
-uint8_t INESRom::getMapper() const
+// Size of the trainer, PRG, CHR and PlayChoice-10 data the header declares
+size_t INESRom::getDataSize() const
+{
+    return (hasTrainer() ? TRAINER_SIZE : 0) + getPrgRomBanks() * PRG_ROM_BANK_SIZE +
+           getChrRomBanks() * CHR_ROM_BANK_SIZE + (hasPlayChoice10() ? PLAY_CHOICE_10_SIZE : 0);
+}
+
+const uint8_t* INESRom::getData() const
 {
-    uint8_t l = _header.flag6 & Flag6::MAPPER_LOWER;
-    uint8_t h = _header.flag7 & Flag7::MAPPER_UPPER;
-    return h | (l >> 4);
+    return _data;
+}
+
+uint16_t INESRom::getMapper() const
+{
+    uint16_t l = _header.flag6 & Flag6::MAPPER_LOWER;
+    uint16_t h = _header.flag7 & Flag7::MAPPER_UPPER;
+    uint16_t highest = isNES2Format() ? _header.prgRamBanks & Flag8::MAPPER_HIGHEST : 0;
+    return (highest << 8) | h | (l >> 4);
+}
+
+// Board variant of the mapper, always 0 for iNES 1.0
+uint8_t INESRom::getSubmapper() const
+{
+    return isNES2Format() ? (_header.prgRamBanks & Flag8::SUBMAPPER) >> 4 : 0;
+}
+
+const INESRom::INESHeader& INESRom::getHeader() const
+{
+    return _header;
 }
 
 INESRom::Mirroring INESRom::getMirroring() const
 {
-    return static_cast<Mirroring >(_header.flag9 & Flag6::MIRRORING);
+    return static_cast<Mirroring >(_header.flag6 & Flag6::MIRRORING);
 }
 
 INESRom::TVSystem INESRom::getTVSystem() const
 {
+    if (isNES2Format())
+    {
+        return static_cast<TVSystem>(_header.flag12 & Flag12::TIMING);
+    }
+
     return static_cast<TVSystem>(_header.flag9 & Flag9::TV_SYSTEM);
 }
 
@@ -150,22 +309,74 @@ bool INESRom::hasPlayChoice10() const
 
 bool INESRom::isNES2Format() const
 {
-    return _header.flag7 & Flag7::NES2_FORMAT == 0b1000;
+    return (_header.flag7 & Flag7::NES2_FORMAT) == 0b1000;
 }
 
-uint8_t INESRom::getPrgRomBanks() const
+uint16_t INESRom::getPrgRomBanks() const
 {
-    return _header.prgRomBanks;
+    uint16_t upper = isNES2Format() ? _header.flag9 & Flag9::PRG_ROM_BANKS_UPPER : 0;
+    return (upper << 8) | _header.prgRomBanks;
 }
 
-uint8_t INESRom::getChrRomBanks() const
+uint16_t INESRom::getChrRomBanks() const
 {
-    return _header.chrRomBanks;
+    uint16_t upper = isNES2Format() ? _header.flag9 & Flag9::CHR_ROM_BANKS_UPPER : 0;
+    return (upper << 4) | _header.chrRomBanks;
 }
 
+// Raw iNES 1.0 PRG RAM byte; use getPrgRamSize and getPrgNvramSize to size RAM
 uint8_t INESRom::getPrgRamBanks() const
 {
-    return _header.prgRamBanks;
+    return isNES2Format() ? 0 : _header.prgRamBanks;
+}
+
+// Volatile PRG RAM in bytes. iNES 1.0 cannot tell it apart from battery-backed RAM, so without a battery
+// all of its PRG RAM is counted here, 8 KiB if it declares none.
+uint32_t INESRom::getPrgRamSize() const
+{
+    if (isNES2Format())
+    {
+        return getNES2RamSize(_header.flag10 & Flag10::RAM_SHIFT);
+    }
+
+    return hasPersistentMemory() ? 0 : getInesPrgRamSize();
+}
+
+// Battery-backed PRG RAM in bytes, the part that has to be saved
+uint32_t INESRom::getPrgNvramSize() const
+{
+    if (isNES2Format())
+    {
+        return getNES2RamSize((_header.flag10 & Flag10::NVRAM_SHIFT) >> 4);
+    }
+
+    return hasPersistentMemory() ? getInesPrgRamSize() : 0;
+}
+
+// Volatile CHR RAM in bytes. iNES 1.0 implies 8 KiB when there is no CHR ROM.
+uint32_t INESRom::getChrRamSize() const
+{
+    if (isNES2Format())
+    {
+        return getNES2RamSize(_header.flag11 & Flag10::RAM_SHIFT);
+    }
+
+    return getChrRomBanks() == 0 ? CHR_ROM_BANK_SIZE : 0;
+}
+
+uint32_t INESRom::getChrNvramSize() const
+{
+    return isNES2Format() ? getNES2RamSize((_header.flag11 & Flag10::NVRAM_SHIFT) >> 4) : 0;
+}
+
+uint32_t INESRom::getInesPrgRamSize() const
+{
+    return (_header.prgRamBanks ? _header.prgRamBanks : 1) * PRG_RAM_BANK_SIZE;
+}
+
+uint32_t INESRom::getNES2RamSize(uint8_t shift)
+{
+    return shift ? 64u << shift : 0;
 }
 
 const INESRom::Bank* INESRom::getTrainer() const
@@ -175,12 +386,12 @@ const INESRom::Bank* INESRom::getTrainer() const
 
 const INESRom::Bank* INESRom::getPrgRomBank(int bank) const
 {
-    return _prgRoms[bank];
+    return &_prgRoms[bank];
 }
 
 const INESRom::Bank* INESRom::getChrRomBank(int bank) const
 {
-    return _chrRoms[bank];
+    return &_chrRoms[bank];
 }
 
 const INESRom::Bank* INESRom::getPlayChoice10() const
@@ -188,15 +399,51 @@ const INESRom::Bank* INESRom::getPlayChoice10() const
     return &_playChoice10;
 }
 
-void INESRom::clear()
+// CRC-32 of all PRG ROM banks, the checksum ROM databases identify games by
+uint32_t INESRom::getPrgHash() const
 {
-    for (auto& bank : _prgRoms) delete bank;
-    for (auto& bank : _chrRoms) delete bank;
+    return hashBanks(_prgRoms, _prgHash);
+}
 
+// CRC-32 of all CHR ROM banks, 0 for CHR RAM boards
+uint32_t INESRom::getChrHash() const
+{
+    return hashBanks(_chrRoms, _chrHash);
+}
+
+// Banks of one kind are contiguous in every storage mode, so they are hashed in one piece
+uint32_t INESRom::hashBanks(const std::vector<Bank>& banks, std::atomic<uint64_t>& cache)
+{
+    auto cached = cache.load(std::memory_order_acquire);
+    if (cached & HASHED)
+    {
+        return static_cast<uint32_t>(cached);
+    }
+
+    uint32_t hash = banks.empty() ? 0 : Crc32::compute(banks.front().getData(), banks.size() * banks.front().getSize());
+    cache.store(HASHED | hash, std::memory_order_release);
+    return hash;
+}
+
+void INESRom::clear()
+{
     _playChoice10.clear();
     _trainer.clear();
     _prgRoms.clear();
     _chrRoms.clear();
+    _data = nullptr;
+    _prgHash = 0;
+    _chrHash = 0;
+
+    delete[] _arena;
+    _arena = nullptr;
+
+    if (_mapping)
+    {
+        munmap(const_cast<uint8_t*>(_mapping), _mappingSize);
+        _mapping = nullptr;
+        _mappingSize = 0;
+    }
 
     memset(&_header, 0x00, sizeof(INESHeader));
 }
@@ -1,6 +1,7 @@
 #ifndef NESCORE_INESLOADER_H
 #define NESCORE_INESLOADER_H
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <istream>
@@ -20,11 +21,13 @@ class INESRom
 {
 public:
     static const char FORMAT[4];
+    static const uint16_t HEADER_SIZE = 0x10;
     static const uint16_t TRAINER_SIZE = 0x200;
     static const uint16_t PRG_ROM_BANK_SIZE = 0x4000;
     static const uint16_t CHR_ROM_BANK_SIZE = 0x2000;
     static const uint16_t PLAY_CHOICE_10_SIZE = 0x2000;
     static const uint16_t PRG_RAM_BANK_SIZE = 0x2000;
+    static const size_t DATA_ALIGNMENT = 64;
 
 public:
 
@@ -35,20 +38,33 @@ public:
         uint8_t chrRomBanks;
         uint8_t flag6;
         uint8_t flag7;
+        // NES 2.0 uses byte 8 for the upper mapper bits and the submapper
         uint8_t prgRamBanks;
         uint8_t flag9;
+        uint8_t flag10;
+        uint8_t flag11;
+        uint8_t flag12;
+        uint8_t flag13;
+        uint8_t flag14;
+        uint8_t flag15;
     };
 
     enum Mirroring
     {
         HORIZONTAL = 0,
-        VERTICAL = 1
+        VERTICAL = 1,
+        // Only selected by mappers at runtime
+        SINGLE_SCREEN_LOWER = 2,
+        SINGLE_SCREEN_UPPER = 3
     };
 
     enum TVSystem
     {
         NTSC,
         PAL,
+        // NES 2.0 only
+        MULTI_REGION,
+        DENDY
     };
 
     class Bank : public IMemoryAccessor
@@ -63,12 +79,15 @@ public:
         uint8_t readByte(uint16_t offset) const override;
 
         uint16_t getSize() const;
+        const uint8_t* getData() const;
         void read(std::istream& stream);
+        void view(const uint8_t* data);
         void clear();
 
     private:
         uint16_t _size;
         uint8_t* _data;
+        bool _owned;
     };
 
 public:
@@ -77,18 +96,30 @@ public:
     ~INESRom();
 
     void read(std::istream& stream);
+    void load(const std::string& fileName);
+    void parse(const uint8_t* data, size_t size);
 
+    const INESHeader& getHeader() const;
     Mirroring getMirroring() const;
     TVSystem getTVSystem() const;
-    uint8_t getMapper() const;
-    uint8_t getPrgRomBanks() const;
-    uint8_t getChrRomBanks() const;
+    uint16_t getMapper() const;
+    uint8_t getSubmapper() const;
+    uint16_t getPrgRomBanks() const;
+    uint16_t getChrRomBanks() const;
     uint8_t getPrgRamBanks() const;
+    uint32_t getPrgRamSize() const;
+    uint32_t getPrgNvramSize() const;
+    uint32_t getChrRamSize() const;
+    uint32_t getChrNvramSize() const;
 
     const Bank* getTrainer() const;
     const Bank* getPrgRomBank(int bank) const;
     const Bank* getChrRomBank(int bank) const;
     const Bank* getPlayChoice10() const;
+    const uint8_t* getData() const;
+    size_t getDataSize() const;
+    uint32_t getPrgHash() const;
+    uint32_t getChrHash() const;
 
     bool hasPersistentMemory() const;
     bool hasTrainer() const;
@@ -115,20 +146,56 @@ private:
         MAPPER_UPPER = 0b11110000
     };
 
+    enum Flag8
+    {
+        SUBMAPPER = 0b11110000,
+        MAPPER_HIGHEST = 0b00001111
+    };
+
     enum Flag9
     {
-        TV_SYSTEM = 0b00000001
+        TV_SYSTEM = 0b00000001,
+        PRG_ROM_BANKS_UPPER = 0b00001111,
+        CHR_ROM_BANKS_UPPER = 0b11110000
+    };
+
+    // Flag10 and Flag11 hold volatile (lower) and battery-backed (upper) RAM sizes as 64 << shift bytes
+    enum Flag10
+    {
+        RAM_SHIFT = 0b00001111,
+        NVRAM_SHIFT = 0b11110000
     };
 
+    enum Flag12
+    {
+        TIMING = 0b00000011
+    };
+
+private:
+    static const uint64_t HASHED = 1ull << 32;
+
 private:
     void clear();
+    void decodeHeader(const uint8_t* data, size_t size);
+    void viewBanks(const uint8_t* data, size_t size);
+    uint32_t getInesPrgRamSize() const;
+    static uint32_t getNES2RamSize(uint8_t shift);
+    static uint32_t hashBanks(const std::vector<Bank>& banks, std::atomic<uint64_t>& cache);
 
 private:
     INESHeader _header;
+    uint8_t* _arena;
+    const uint8_t* _data;
+    const uint8_t* _mapping;
+    size_t _mappingSize;
     Bank _trainer;
     Bank _playChoice10;
-    std::vector<Bank*> _prgRoms;
-    std::vector<Bank*> _chrRoms;
+    std::vector<Bank> _prgRoms;
+    std::vector<Bank> _chrRoms;
+    // CRC-32 of the PRG and CHR ROM, computed on first use. HASHED is set once the low word is valid;
+    // concurrent first calls compute the same value, so the race is benign.
+    mutable std::atomic<uint64_t> _prgHash;
+    mutable std::atomic<uint64_t> _chrHash;
 };
 
 std::istream& operator >>(std::istream& stream, INESRom& rom);
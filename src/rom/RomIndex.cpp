@@ -0,0 +1,288 @@
+#include <memory.h>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "RomIndex.h"
+#include "INESRom.h"
+
+namespace nescore
+{
+
+const char RomIndex::FORMAT[] = { 'N', 'E', 'S', 'I' };
+const uint32_t RomIndex::VERSION;
+
+namespace
+{
+
+bool hasRomExtension(const std::string& name)
+{
+    if (name.size() < 4)
+    {
+        return false;
+    }
+
+    std::string extension = name.substr(name.size() - 4);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".nes";
+}
+
+void findRoms(const std::string& directory, std::vector<std::string>& files)
+{
+    DIR* dir = opendir(directory.c_str());
+    if (!dir)
+    {
+        return;
+    }
+
+    while (auto entry = readdir(dir))
+    {
+        std::string name = entry->d_name;
+        if (name == "." || name == "..")
+        {
+            continue;
+        }
+
+        // Symlinks to files are followed, symlinks to directories are not so the walk cannot loop
+        std::string path = directory + "/" + name;
+        struct stat info;
+        if (lstat(path.c_str(), &info) != 0)
+        {
+            continue;
+        }
+        if (S_ISDIR(info.st_mode))
+        {
+            findRoms(path, files);
+            continue;
+        }
+        if (S_ISLNK(info.st_mode) && stat(path.c_str(), &info) != 0)
+        {
+            continue;
+        }
+        if (S_ISREG(info.st_mode) && hasRomExtension(name))
+        {
+            files.push_back(path);
+        }
+    }
+
+    closedir(dir);
+}
+
+}
+
+RomIndex::Entry RomIndex::Entry::fromRom(const INESRom& rom)
+{
+    Entry entry = {};
+    entry.mapper = rom.getMapper();
+    entry.submapper = rom.getSubmapper();
+    entry.prgRomBanks = rom.getPrgRomBanks();
+    entry.chrRomBanks = rom.getChrRomBanks();
+
+    entry.prgCrc = rom.getPrgHash();
+    entry.chrCrc = rom.getChrHash();
+
+    entry.flags |= rom.getMirroring() == INESRom::VERTICAL ? VERTICAL_MIRRORING : 0;
+    entry.flags |= rom.getIgnoreMirroring() ? FOUR_SCREEN : 0;
+    entry.flags |= rom.hasPersistentMemory() ? BATTERY : 0;
+    entry.flags |= rom.hasTrainer() ? TRAINER : 0;
+    entry.flags |= rom.isNES2Format() ? NES2_FORMAT : 0;
+    return entry;
+}
+
+bool RomIndex::Entry::hasChrRam() const
+{
+    return chrRomBanks == 0;
+}
+
+RomIndex::RomIndex()
+    : _entryData(nullptr)
+    , _pathData(nullptr)
+    , _size(0)
+    , _mapping(nullptr)
+    , _mappingSize(0)
+{
+}
+
+RomIndex::~RomIndex()
+{
+    close();
+}
+
+// All .nes files below directory, sorted so that indices are reproducible
+std::vector<std::string> RomIndex::findRoms(const std::string& directory)
+{
+    std::vector<std::string> files;
+    nescore::findRoms(directory, files);
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// Indexes every ROM below directory with a pool of threads, one per core by default.
+// Files that are not valid iNES images are skipped.
+void RomIndex::scan(const std::string& directory, unsigned threads)
+{
+    close();
+
+    auto files = findRoms(directory);
+    std::vector<Entry> entries(files.size());
+    std::vector<char> valid(files.size(), 0);
+    std::atomic<size_t> next(0);
+
+    auto worker = [&]()
+    {
+        INESRom rom;
+        for (size_t i = next++; i < files.size(); i = next++)
+        {
+            try
+            {
+                rom.load(files[i]);
+                entries[i] = Entry::fromRom(rom);
+                valid[i] = 1;
+            }
+            catch (...)
+            {
+                // Unreadable or invalid files are left out of the index
+            }
+        }
+    };
+
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<std::thread> pool;
+    for (unsigned i = 0; i < threads; ++i)
+    {
+        pool.emplace_back(worker);
+    }
+    for (auto& thread : pool)
+    {
+        thread.join();
+    }
+
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        if (!valid[i])
+        {
+            continue;
+        }
+
+        entries[i].pathOffset = _paths.size();
+        _paths.append(files[i]);
+        _paths.push_back('\0');
+        _entries.push_back(entries[i]);
+    }
+
+    _entryData = _entries.data();
+    _pathData = _paths.data();
+    _size = _entries.size();
+}
+
+void RomIndex::save(const std::string& fileName) const
+{
+    FileHeader header = {};
+    memcpy(header.format, FORMAT, sizeof(FORMAT));
+    header.version = VERSION;
+    header.count = _size;
+    auto pathsEnd = _size > 0 ? getPath(_size - 1) + strlen(getPath(_size - 1)) + 1 : _pathData;
+    header.pathsSize = pathsEnd - _pathData;
+
+    std::ofstream file(fileName, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(_entryData), _size * sizeof(Entry));
+    file.write(_pathData, header.pathsSize);
+    if (!file)
+    {
+        throw nesformat_error("Unable to write " + fileName);
+    }
+}
+
+// Maps an index written by save. Entries and paths are used in place.
+void RomIndex::open(const std::string& fileName)
+{
+    close();
+
+    int file = ::open(fileName.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        throw nesformat_error("Unable to open " + fileName);
+    }
+
+    struct stat info;
+    void* mapping = MAP_FAILED;
+    if (fstat(file, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(FileHeader)))
+    {
+        mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, file, 0);
+    }
+    ::close(file);
+    if (mapping == MAP_FAILED)
+    {
+        throw nesformat_error("Unable to map " + fileName);
+    }
+
+    _mapping = mapping;
+    _mappingSize = info.st_size;
+
+    auto data = static_cast<const uint8_t*>(mapping);
+    auto header = reinterpret_cast<const FileHeader*>(data);
+    size_t entriesSize = static_cast<size_t>(header->count) * sizeof(Entry);
+    if (memcmp(header->format, FORMAT, sizeof(FORMAT)) != 0 || header->version != VERSION ||
+        sizeof(FileHeader) + entriesSize + header->pathsSize > _mappingSize ||
+        (header->pathsSize > 0 && data[sizeof(FileHeader) + entriesSize + header->pathsSize - 1] != '\0'))
+    {
+        close();
+        throw nesformat_error("Invalid ROM index " + fileName);
+    }
+
+    _entryData = reinterpret_cast<const Entry*>(data + sizeof(FileHeader));
+    _pathData = reinterpret_cast<const char*>(data + sizeof(FileHeader) + entriesSize);
+    _size = header->count;
+
+    // The blob ends with a terminator, so any offset inside it yields a terminated path
+    for (uint32_t i = 0; i < _size; ++i)
+    {
+        if (_entryData[i].pathOffset >= header->pathsSize)
+        {
+            close();
+            throw nesformat_error("Invalid ROM index " + fileName);
+        }
+    }
+}
+
+uint32_t RomIndex::getSize() const
+{
+    return _size;
+}
+
+const RomIndex::Entry& RomIndex::getEntry(uint32_t index) const
+{
+    return _entryData[index];
+}
+
+const char* RomIndex::getPath(uint32_t index) const
+{
+    return _pathData + _entryData[index].pathOffset;
+}
+
+void RomIndex::close()
+{
+    if (_mapping)
+    {
+        munmap(_mapping, _mappingSize);
+        _mapping = nullptr;
+        _mappingSize = 0;
+    }
+
+    _entries.clear();
+    _paths.clear();
+    _entryData = nullptr;
+    _pathData = nullptr;
+    _size = 0;
+}
+
+}
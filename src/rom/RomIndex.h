@@ -0,0 +1,84 @@
+#ifndef NESCORE_ROMINDEX_H
+#define NESCORE_ROMINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nescore
+{
+
+class INESRom;
+
+// Header summary of a ROM corpus. The index file is a small header, a fixed-size record per ROM
+// and the null-terminated paths, so it can be mapped and queried in place.
+class RomIndex
+{
+public:
+    static const char FORMAT[4];
+    static const uint32_t VERSION = 2;
+
+    enum Flags
+    {
+        VERTICAL_MIRRORING = 0b00000001,
+        FOUR_SCREEN = 0b00000010,
+        BATTERY = 0b00000100,
+        TRAINER = 0b00001000,
+        NES2_FORMAT = 0b00010000
+    };
+
+    struct Entry
+    {
+        uint32_t prgCrc;
+        uint32_t chrCrc;
+        uint32_t pathOffset;
+        uint16_t mapper;
+        uint16_t prgRomBanks;
+        uint16_t chrRomBanks;
+        uint8_t flags;
+        uint8_t submapper;
+
+        static Entry fromRom(const INESRom& rom);
+
+        bool hasChrRam() const;
+    };
+
+    struct FileHeader
+    {
+        char format[4];
+        uint32_t version;
+        uint32_t count;
+        uint32_t pathsSize;
+    };
+
+public:
+    RomIndex();
+    RomIndex(const RomIndex&) = delete;
+    ~RomIndex();
+
+    static std::vector<std::string> findRoms(const std::string& directory);
+    void scan(const std::string& directory, unsigned threads = 0);
+    void save(const std::string& fileName) const;
+    void open(const std::string& fileName);
+
+    uint32_t getSize() const;
+    const Entry& getEntry(uint32_t index) const;
+    const char* getPath(uint32_t index) const;
+
+private:
+    void close();
+
+private:
+    // Either filled by scan or pointing into the mapped index file
+    std::vector<Entry> _entries;
+    std::string _paths;
+    const Entry* _entryData;
+    const char* _pathData;
+    uint32_t _size;
+    void* _mapping;
+    size_t _mappingSize;
+};
+
+}
+
+#endif //NESCORE_ROMINDEX_H
@@ -0,0 +1,118 @@
+#include <memory.h>
+#include <algorithm>
+#include "RomRegistry.h"
+
+namespace nescore
+{
+
+namespace
+{
+
+const uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325;
+const uint64_t FNV_PRIME = 0x100000001B3;
+
+uint64_t hashBytes(uint64_t hash, const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ data[i]) * FNV_PRIME;
+    }
+
+    return hash;
+}
+
+}
+
+RomRegistry& RomRegistry::getInstance()
+{
+    static RomRegistry registry;
+    return registry;
+}
+
+std::shared_ptr<const INESRom> RomRegistry::load(const std::string& fileName)
+{
+    auto rom = std::make_shared<INESRom>();
+    rom->load(fileName);
+    return add(rom);
+}
+
+// Returns the registered ROM with the same contents as rom, or registers rom if there is none.
+// The registry takes rom over and only hands it out as const, so no holder can change it under the others.
+std::shared_ptr<const INESRom> RomRegistry::add(std::shared_ptr<INESRom> rom)
+{
+    auto key = hash(*rom);
+
+    // Locked candidates are released after the mutex, since dropping the last one runs release
+    std::vector<std::shared_ptr<const INESRom>> alive;
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& candidates = _roms[key];
+    for (auto& entry : candidates)
+    {
+        auto existing = entry.lock();
+        if (!existing)
+        {
+            continue;
+        }
+        if (equals(*existing, *rom))
+        {
+            return existing;
+        }
+        alive.push_back(std::move(existing));
+    }
+
+    // The deleter keeps the original owner alive and unregisters the ROM once its last user is gone
+    std::shared_ptr<const INESRom> shared(rom.get(), [this, key, rom](const INESRom*) { release(key); });
+    candidates.push_back(shared);
+    return shared;
+}
+
+// Number of registered ROMs that are still alive
+size_t RomRegistry::getSize()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t size = 0;
+    for (auto& candidates : _roms)
+    {
+        size += std::count_if(candidates.second.begin(), candidates.second.end(),
+                              [](const std::weak_ptr<const INESRom>& entry) { return !entry.expired(); });
+    }
+
+    return size;
+}
+
+// Drops the expired entries of key, and key itself once none are left
+void RomRegistry::release(uint64_t key)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _roms.find(key);
+    if (it == _roms.end())
+    {
+        return;
+    }
+
+    auto& candidates = it->second;
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                    [](const std::weak_ptr<const INESRom>& entry) { return entry.expired(); }),
+                     candidates.end());
+    if (candidates.empty())
+    {
+        _roms.erase(it);
+    }
+}
+
+// FNV-1a over the header fields and the cached PRG and CHR CRCs. Collisions are resolved by equals
+uint64_t RomRegistry::hash(const INESRom& rom)
+{
+    auto& header = rom.getHeader();
+    uint32_t crcs[] = { rom.getPrgHash(), rom.getChrHash() };
+    auto hash = hashBytes(FNV_OFFSET_BASIS, reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+    return hashBytes(hash, reinterpret_cast<const uint8_t*>(crcs), sizeof(crcs));
+}
+
+bool RomRegistry::equals(const INESRom& a, const INESRom& b)
+{
+    return memcmp(&a.getHeader(), &b.getHeader(), sizeof(INESRom::INESHeader)) == 0 &&
+           memcmp(a.getData(), b.getData(), a.getDataSize()) == 0;
+}
+
+}
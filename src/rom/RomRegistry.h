@@ -0,0 +1,42 @@
+#ifndef NESCORE_ROMREGISTRY_H
+#define NESCORE_ROMREGISTRY_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "INESRom.h"
+
+namespace nescore
+{
+
+// Process-wide set of loaded ROMs keyed by a hash of their header and bank data.
+// Loading a ROM that is already alive returns the existing instance, so every console running the same
+// game shares one copy of its banks. Registered ROMs are only handed out as const and are held weakly;
+// the last user to drop one also removes it from the registry. Thread safe.
+class RomRegistry
+{
+public:
+    static RomRegistry& getInstance();
+
+public:
+    std::shared_ptr<const INESRom> load(const std::string& fileName);
+    std::shared_ptr<const INESRom> add(std::shared_ptr<INESRom> rom);
+    size_t getSize();
+
+    static uint64_t hash(const INESRom& rom);
+    static bool equals(const INESRom& a, const INESRom& b);
+
+private:
+    void release(uint64_t key);
+
+private:
+    std::mutex _mutex;
+    std::unordered_map<uint64_t, std::vector<std::weak_ptr<const INESRom>>> _roms;
+};
+
+}
+
+#endif //NESCORE_ROMREGISTRY_H
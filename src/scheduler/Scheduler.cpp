@@ -0,0 +1,77 @@
+#include <limits>
+#include "Scheduler.h"
+
+namespace nescore
+{
+
+const cpu_cycle_t Scheduler::NEVER = std::numeric_limits<cpu_cycle_t>::max();
+
+Scheduler::Scheduler()
+    : _nextDeadline(NEVER)
+    , _nextEvent(EVENTS_COUNT)
+{
+    for (auto& deadline : _deadlines)
+    {
+        deadline = NEVER;
+    }
+}
+
+void Scheduler::setHandler(Scheduler::Event event, Scheduler::Handler handler)
+{
+    _handlers[event] = handler;
+}
+
+void Scheduler::schedule(Scheduler::Event event, cpu_cycle_t cycle)
+{
+    _deadlines[event] = cycle;
+    updateNextDeadline();
+}
+
+void Scheduler::cancel(Scheduler::Event event)
+{
+    _deadlines[event] = NEVER;
+    updateNextDeadline();
+}
+
+void Scheduler::runNext()
+{
+    if (_nextEvent == EVENTS_COUNT)
+    {
+        return;
+    }
+
+    auto event = _nextEvent;
+    auto deadline = _deadlines[event];
+    cancel(event);
+
+    if (_handlers[event])
+    {
+        _handlers[event](deadline);
+    }
+}
+
+bool Scheduler::isScheduled(Scheduler::Event event) const
+{
+    return _deadlines[event] != NEVER;
+}
+
+cpu_cycle_t Scheduler::getDeadline(Scheduler::Event event) const
+{
+    return _deadlines[event];
+}
+
+void Scheduler::updateNextDeadline()
+{
+    _nextDeadline = NEVER;
+    _nextEvent = EVENTS_COUNT;
+    for (int i = 0; i < EVENTS_COUNT; ++i)
+    {
+        if (_deadlines[i] < _nextDeadline)
+        {
+            _nextDeadline = _deadlines[i];
+            _nextEvent = static_cast<Event>(i);
+        }
+    }
+}
+
+}
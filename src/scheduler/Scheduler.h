@@ -0,0 +1,58 @@
+#ifndef NESCORE_SCHEDULER_H
+#define NESCORE_SCHEDULER_H
+
+#include <functional>
+#include "../cpu/CPU.h"
+
+namespace nescore
+{
+
+// Keeps one pending deadline per event type, keyed on the CPU cycle counter.
+// The owner only compares its cycle counter against getNextDeadline() and
+// calls runNext() once it is reached, so idle cycles cost nothing.
+class Scheduler
+{
+public:
+    static const cpu_cycle_t NEVER;
+
+    enum Event
+    {
+        DmaTransfer = 0,
+        Nmi,
+        Irq,
+        MapperIrq,
+        EVENTS_COUNT
+    };
+
+    using Handler = std::function<void(cpu_cycle_t deadline)>;
+
+public:
+    Scheduler();
+
+    void setHandler(Event event, Handler handler);
+    void schedule(Event event, cpu_cycle_t cycle);
+    void cancel(Event event);
+    void runNext();
+
+    bool isScheduled(Event event) const;
+    cpu_cycle_t getDeadline(Event event) const;
+    cpu_cycle_t getNextDeadline() const;
+
+private:
+    void updateNextDeadline();
+
+private:
+    cpu_cycle_t _deadlines[EVENTS_COUNT];
+    Handler _handlers[EVENTS_COUNT];
+    cpu_cycle_t _nextDeadline;
+    Event _nextEvent;
+};
+
+inline cpu_cycle_t Scheduler::getNextDeadline() const
+{
+    return _nextDeadline;
+}
+
+}
+
+#endif //NESCORE_SCHEDULER_H
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <cpu/BlockCache.h>
+#include <cpu/CPUMemory.h>
+
+using namespace nescore;
+
+static void readBank(INESRom::Bank& bank, const std::vector<uint8_t>& program)
+{
+    std::string data(bank.getSize(), '\0');
+    std::copy(program.begin(), program.end(), data.begin());
+    std::istringstream stream(data);
+    bank.read(stream);
+}
+
+TEST(BlockCache, Decode_until_branch)
+{
+    CPUMemory memory;
+    INESRom::Bank bank(INESRom::PRG_ROM_BANK_SIZE);
+    readBank(bank, { 0xA9, 0x01, 0x8D, 0x00, 0x02, 0xCA, 0xD0, 0xF8, 0xEA });
+    memory.mount(Memory::Range(0x8000, 0xBFFF), &bank);
+
+    BlockCache cache;
+    auto block = cache.find(0x8000, memory);
+
+    ASSERT_NE(block, nullptr);
+    ASSERT_EQ(block->length, 2);
+    ASSERT_EQ(block->end, 0x8005);
+    ASSERT_EQ(block->instructions[1].operand[1], 0x02);
+    ASSERT_EQ(block->maxCycles, 6);
+    ASSERT_EQ(cache.find(0x8005, memory)->length, 2);
+    ASSERT_EQ(cache.find(0x8005, memory)->maxCycles, 6);
+}
+
+TEST(BlockCache, RAM_is_not_cached)
+{
+    CPUMemory memory({ 0xEA, 0xEA });
+    BlockCache cache;
+
+    ASSERT_EQ(cache.find(0x0000, memory), nullptr);
+}
+
+TEST(BlockCache, Remap_bank)
+{
+    CPUMemory memory;
+    INESRom::Bank bank1(INESRom::PRG_ROM_BANK_SIZE);
+    INESRom::Bank bank2(INESRom::PRG_ROM_BANK_SIZE);
+    readBank(bank1, { 0xEA, 0xEA, 0x60 });
+    readBank(bank2, { 0xE8, 0x60 });
+    memory.mount(Memory::Range(0x8000, 0xBFFF), &bank1);
+
+    BlockCache cache;
+    ASSERT_EQ(cache.find(0x8000, memory)->length, 3);
+
+    memory.mount(Memory::Range(0x8000, 0xBFFF), &bank2);
+    auto block = cache.find(0x8000, memory);
+
+    ASSERT_EQ(block->length, 2);
+    ASSERT_EQ(block->instructions[0].opcode, 0xE8);
+}
+
+TEST(BlockCache, RunFor)
+{
+    CPU cpu(std::make_shared<CPUMemory>(CPUMemory::Flat));
+    INESRom::Bank bank(INESRom::PRG_ROM_BANK_SIZE);
+    readBank(bank, { 0xA2, 0x00, 0xE8, 0x86, 0x10, 0xE0, 0x20, 0xD0, 0xF9, 0x02 });
+    cpu.getMemory()->mount(Memory::Range(0x8000, 0xBFFF), &bank);
+    cpu.getMemory()->setResetVector(0x8000);
+    cpu.reset();
+    cpu.setBlockCacheEnabled(true);
+
+    cpu.runFor(10000);
+
+    ASSERT_EQ(cpu.getRegisters().X, 0x20);
+    ASSERT_EQ(cpu.getMemory()->readByte(0x10), 0x20);
+    ASSERT_EQ(cpu.getRegisters().PC, 0x800A);
+}
+
+TEST(BlockCache, Operands_come_from_block)
+{
+    std::vector<uint8_t> rom(INESRom::PRG_ROM_BANK_SIZE);
+    std::vector<uint8_t> program = { 0xA9, 0x11, 0x85, 0x10, 0x8D, 0x00, 0x03, 0x02 };
+    std::copy(program.begin(), program.end(), rom.begin());
+    INESRom::Bank bank(INESRom::PRG_ROM_BANK_SIZE);
+    bank.view(rom.data());
+
+    CPU cpu(std::make_shared<CPUMemory>(CPUMemory::Flat));
+    cpu.getMemory()->mount(Memory::Range(0x8000, 0xBFFF), &bank);
+    cpu.getMemory()->setResetVector(0x8000);
+    cpu.setBlockCacheEnabled(true);
+    cpu.reset();
+    cpu.runFor(100);
+
+    // The block is still mapped from the same page, so it runs with the operands it was decoded with
+    rom[1] = 0x22;
+    rom[3] = 0x20;
+    rom[6] = 0x04;
+    cpu.reset();
+    cpu.runFor(100);
+
+    ASSERT_EQ(cpu.getRegisters().A, 0x11);
+    ASSERT_EQ(cpu.getMemory()->readByte(0x20), 0x00);
+    ASSERT_EQ(cpu.getMemory()->readByte(0x0400), 0x00);
+
+    cpu.setBlockCacheEnabled(false);
+    cpu.reset();
+    cpu.runFor(100);
+
+    ASSERT_EQ(cpu.getRegisters().A, 0x22);
+    ASSERT_EQ(cpu.getMemory()->readByte(0x20), 0x22);
+    ASSERT_EQ(cpu.getMemory()->readByte(0x0400), 0x22);
+}
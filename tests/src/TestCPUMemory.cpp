@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
+#include <sstream>
+#include <cpu/CPU.h>
 #include <cpu/CPUMemory.h>
+#include <mappers/IRomMapper.h>
 
 using namespace nescore;
 
@@ -85,4 +88,270 @@ TEST(Memory, Write_bytes)
     ASSERT_EQ(memory.readByte(CPUMemory::ROM_OFFSET), 0xF0);
     ASSERT_EQ(memory.readByte(CPUMemory::ROM_OFFSET + 1), 0xFD);
     ASSERT_EQ(memory.readByte(CPUMemory::ROM_OFFSET + 2), 0x78);
-}
\ No newline at end of file
+}
+
+TEST(Memory, Mount_part_of_page)
+{
+    CPUMemory memory({ 0x01, 0x02, 0x03 });
+    uint8_t buffer[] = { 0xAA, 0xBB };
+
+    memory.mount(Memory::Range(0x0001, 0x0002), buffer);
+
+    ASSERT_EQ(memory.readByte(0x0000), 0x01);
+    ASSERT_EQ(memory.readByte(0x0001), 0xAA);
+    ASSERT_EQ(memory.readByte(0x0002), 0xBB);
+
+    memory.writeByte(0x0002, 0xCC);
+
+    ASSERT_EQ(buffer[1], 0xCC);
+    ASSERT_EQ(memory.readByte(0x0800), 0x01);
+}
+
+TEST(Memory, CPU_default_layout)
+{
+    CPU cpu;
+
+    ASSERT_EQ(cpu.getMemory()->getLayout(), CPUMemory::Flat);
+    ASSERT_NO_THROW(cpu.getMemory()->loadProgram({ 0xEA }));
+    ASSERT_EQ(cpu.getMemory()->readByte(CPUMemory::ROM_OFFSET), 0xEA);
+}
+
+TEST(Memory, Compact_RAM_Mirror)
+{
+    CPUMemory memory(CPUMemory::Compact);
+
+    memory.writeByte(0x0805, 0xFE);
+    memory.writeByte(0x1FFF, 0x42);
+
+    ASSERT_EQ(memory.readByte(0x0005), 0xFE);
+    ASSERT_EQ(memory.readByte(0x1805), 0xFE);
+    ASSERT_EQ(memory.readByte(0x07FF), 0x42);
+    ASSERT_EQ(memory.readByte(0x0000), 0x00);
+}
+
+TEST(Memory, Compact_unmapped)
+{
+    CPUMemory memory(CPUMemory::Compact);
+
+    int writes = 0;
+    memory.addHook(Memory::Range(0x6000, 0x6000), [&writes](uint16_t, uint8_t, uint64_t) { ++writes; });
+
+    memory.writeByte(CPUMemory::ROM_OFFSET, 0x01);
+    memory.writeByte(0x6000, 0x01);
+
+    ASSERT_EQ(memory.readByte(0x4015), 0x40);
+    ASSERT_EQ(memory.readByte(CPUMemory::ROM_OFFSET), CPUMemory::ROM_OFFSET >> 8);
+    ASSERT_EQ(writes, 1);
+}
+
+TEST(Memory, Rom_bank_is_read_only)
+{
+    CPUMemory memory(CPUMemory::Compact);
+    INESRom::Bank bank(INESRom::PRG_ROM_BANK_SIZE);
+    std::istringstream stream(std::string(bank.getSize(), '\0'));
+    bank.read(stream);
+    memory.mount(Memory::Range(0x8000, 0xFFFF), &bank);
+
+    memory.writeByte(0xC000, 0x42);
+
+    ASSERT_EQ(memory.readByte(0xC000), 0x00);
+    ASSERT_EQ(bank.getData()[0], 0x00);
+}
+
+class RegisterMapper : public IRomMapper
+{
+public:
+    void setupCPU(std::shared_ptr<Memory> /* memory */) override {}
+    void setupPPU(std::shared_ptr<PPUMemory> /* memory */) override {}
+    void writeRegister(uint16_t address, uint8_t value) override
+    {
+        lastAddress = address;
+        lastValue = value;
+    }
+
+    uint16_t lastAddress = 0;
+    uint8_t lastValue = 0;
+};
+
+TEST(Memory, Mapper_register)
+{
+    CPUMemory memory(CPUMemory::Compact);
+    RegisterMapper mapper;
+    memory.mount(Memory::Range(0x8000, 0xFFFF), &mapper);
+
+    memory.writeByte(0xA001, 0x80);
+
+    ASSERT_EQ(mapper.lastAddress, 0xA001);
+    ASSERT_EQ(mapper.lastValue, 0x80);
+}
+
+class RegisterFile : public IMemoryAccessor
+{
+public:
+    void writeByte(uint16_t offset, uint8_t value) override
+    {
+        registers[offset] = value;
+    }
+
+    uint8_t readByte(uint16_t offset) const override
+    {
+        return registers[offset];
+    }
+
+    uint8_t registers[8] = {};
+};
+
+TEST(Memory, Mirror_repeats_source)
+{
+    CPUMemory memory(CPUMemory::Compact);
+    RegisterFile registers;
+    memory.mount(Memory::Range(0x2000, 0x2007), &registers);
+    memory.mirror(Memory::Range(0x2000, 0x2007), Memory::Range(0x2008, 0x3FFF));
+
+    memory.writeByte(0x3456, 0x42);
+
+    ASSERT_EQ(registers.registers[6], 0x42);
+    ASSERT_EQ(memory.readByte(0x200E), 0x42);
+    ASSERT_EQ(memory.readByte(0x3FFE), 0x42);
+}
+
+TEST(Memory, Mirror_source_must_be_mounted)
+{
+    CPUMemory memory(CPUMemory::Compact);
+
+    ASSERT_ANY_THROW(memory.mirror(Memory::Range(0x6000, 0x6007), Memory::Range(0x6008, 0x600F)));
+}
+
+TEST(Memory, Bulk_read_across_devices)
+{
+    CPUMemory memory(CPUMemory::Compact);
+    RegisterFile registers;
+    registers.registers[0] = 0x42;
+    memory.mount(Memory::Range(0x2000, 0x2007), &registers);
+    memory.writeByte(0x1FFF, 0x24);
+    uint8_t buffer[2] = {};
+
+    memory.readBytes(buffer, 0x1FFF, 2);
+
+    ASSERT_EQ(buffer[0], 0x24);
+    ASSERT_EQ(buffer[1], 0x42);
+}
+
+TEST(Memory, Bulk_write_and_copy)
+{
+    CPUMemory memory(CPUMemory::Compact);
+    std::vector<uint8_t> data(0x300);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<uint8_t>(i * 7);
+    }
+
+    memory.writeBytes(data.data(), 0x0080, data.size());
+    memory.copyBytes(0x0400, 0x0880, 0x300);
+
+    ASSERT_EQ(memory.readByte(0x0080), data[0]);
+    ASSERT_EQ(memory.readByte(0x037F), data[0x2FF]);
+    ASSERT_EQ(memory.readByte(0x0400), data[0]);
+    ASSERT_EQ(memory.readByte(0x06FF), data[0x2FF]);
+}
+
+TEST(Memory, Write_hook)
+{
+    CPUMemory memory(CPUMemory::Compact);
+    uint64_t clock = 42;
+    memory.setClock(&clock);
+    std::vector<std::pair<uint16_t, uint8_t>> writes;
+    auto id = memory.addHook(Memory::Range(0x0010, 0x0010), [&](uint16_t address, uint8_t value, uint64_t cycle) {
+        ASSERT_EQ(cycle, 42);
+        writes.emplace_back(address, value);
+    });
+
+    memory.writeByte(0x0010, 0x01);
+    memory.writeByte(0x0011, 0x02);
+
+    ASSERT_EQ(writes.size(), 1);
+    ASSERT_EQ(writes[0].first, 0x0010);
+    ASSERT_EQ(writes[0].second, 0x01);
+    ASSERT_EQ(memory.readByte(0x0011), 0x02);
+    ASSERT_TRUE(memory.isDirect(0x0010));
+
+    memory.removeHook(id);
+    memory.writeByte(0x0010, 0x04);
+
+    ASSERT_EQ(writes.size(), 1);
+    ASSERT_EQ(memory.readByte(0x0010), 0x04);
+}
+
+TEST(Memory, Read_hook)
+{
+    CPUMemory memory(CPUMemory::Compact);
+    memory.writeByte(0x0020, 0x42);
+    int reads = 0;
+    memory.addHook(Memory::Range(0x0020, 0x0020), [&](uint16_t, uint8_t value, uint64_t) {
+        ASSERT_EQ(value, 0x42);
+        reads++;
+    }, Memory::Read);
+
+    ASSERT_FALSE(memory.isDirect(0x0020));
+    ASSERT_EQ(memory.readByte(0x0020), 0x42);
+    ASSERT_EQ(memory.readByte(0x0021), 0x00);
+    ASSERT_EQ(reads, 1);
+}
+
+TEST(Memory, Bank_window)
+{
+    CPUMemory memory(CPUMemory::Compact);
+    std::vector<INESRom::Bank> banks;
+    std::vector<const INESRom::Bank*> source;
+    uint16_t bankSize = INESRom::PRG_ROM_BANK_SIZE;
+    banks.reserve(4);
+    for (int i = 0; i < 4; ++i)
+    {
+        std::string data(bankSize, static_cast<char>(i));
+        data[0x2000] = static_cast<char>(0x10 + i);
+        std::istringstream stream(data);
+        banks.emplace_back(bankSize);
+        banks.back().read(stream);
+    }
+    for (auto& bank : banks)
+    {
+        source.push_back(&bank);
+    }
+
+    auto low = memory.addBankWindow(Memory::Range(0x8000, 0x9FFF), source);
+    auto high = memory.addBankWindow(Memory::Range(0xC000, 0xFFFF), source);
+
+    ASSERT_EQ(memory.readByte(0x8000), 0x00);
+    ASSERT_EQ(memory.readByte(0xC000), 0x00);
+    ASSERT_NE(memory.getReadOnlyPage(0x8000), nullptr);
+
+    memory.switchBank(low, 3);
+    memory.switchBank(high, 1);
+
+    ASSERT_EQ(memory.readByte(0x8000), 0x11);
+    ASSERT_EQ(memory.readByte(0x8001), 0x01);
+    ASSERT_EQ(memory.readByte(0xC000), 0x01);
+    ASSERT_EQ(memory.readByte(0xE000), 0x11);
+
+    memory.switchBank(low, 8);
+
+    ASSERT_EQ(memory.readByte(0x8000), 0x00);
+}
+
+TEST(Memory, Bank_window_alignment)
+{
+    CPUMemory memory(CPUMemory::Compact);
+    uint8_t buffer[0x2000];
+
+    ASSERT_ANY_THROW(memory.addBankWindow(Memory::Range(0x6000, 0x6FFE), buffer, sizeof(buffer)));
+    ASSERT_ANY_THROW(memory.addBankWindow(Memory::Range(0x6000, 0x7FFF), buffer, 0x1000));
+}
+
+TEST(Memory, Bank_window_is_not_mirrored)
+{
+    CPUMemory memory(CPUMemory::Compact);
+    uint8_t buffer[0x2000] = {};
+    memory.addBankWindow(Memory::Range(0x6000, 0x6FFF), buffer, sizeof(buffer));
+
+    ASSERT_ANY_THROW(memory.mirror(Memory::Range(0x6000, 0x60FF), Memory::Range(0x7000, 0x70FF)));
+}
@@ -0,0 +1,290 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <cpu/CPU.h>
+#include <cpu/CPUMemory.h>
+#include <mappers/MMC1.h>
+#include <mappers/MMC3.h>
+#include <ppu/PPUMemory.h>
+#include <rom/INESRom.h>
+#include <scheduler/Scheduler.h>
+
+using namespace nescore;
+
+// 64 KiB of PRG ROM with every 8 KiB bank filled with its number, except for the last one which holds
+// an idle loop at $E000 and an IRQ handler at $E100 that counts IRQs in $10, acknowledges and re-enables them.
+// 16 KiB of CHR ROM with every 1 KiB bank filled with its number.
+// A non-zero ramShift makes it a NES 2.0 image with 64 << ramShift bytes of PRG RAM.
+static std::shared_ptr<INESRom> createMMC3Rom(int ramShift = 0, char flag6 = 0x41)
+{
+    std::string data = { 'N', 'E', 'S', 0x1A, 4, 2, flag6, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    if (ramShift)
+    {
+        data[7] = 0x08;
+        data[10] = static_cast<char>(ramShift);
+    }
+    for (int bank = 0; bank < 8; ++bank)
+    {
+        data.append(MMC3::PRG_BANK_SIZE, static_cast<char>(bank));
+    }
+
+    size_t last = data.size() - MMC3::PRG_BANK_SIZE;
+    const uint8_t loop[] = { 0x58, 0x4C, 0x01, 0xE0 };
+    const uint8_t handler[] = { 0xE6, 0x10, 0x8D, 0x00, 0xE0, 0x8D, 0x01, 0xE0, 0x40 };
+    const uint8_t vectors[] = { 0x00, 0xE1, 0x00, 0xE0, 0x00, 0xE1 };
+    std::copy(loop, loop + sizeof(loop), data.begin() + last);
+    std::copy(handler, handler + sizeof(handler), data.begin() + last + 0x100);
+    std::copy(vectors, vectors + sizeof(vectors), data.end() - sizeof(vectors));
+
+    for (int bank = 0; bank < 16; ++bank)
+    {
+        data.append(MMC3::CHR_BANK_SIZE, static_cast<char>(bank));
+    }
+
+    auto rom = std::make_shared<INESRom>();
+    std::istringstream stream(data);
+    rom->read(stream);
+    return rom;
+}
+
+TEST(MMC3, Prg_banks)
+{
+    auto memory = std::make_shared<CPUMemory>(CPUMemory::Compact);
+    MMC3 mapper(createMMC3Rom());
+    mapper.setupCPU(memory);
+
+    memory->writeByte(0x8000, 0x06);
+    memory->writeByte(0x8001, 0x03);
+    memory->writeByte(0x8000, 0x07);
+    memory->writeByte(0x8001, 0x04);
+
+    ASSERT_EQ(memory->readByte(0x8000), 3);
+    ASSERT_EQ(memory->readByte(0xA000), 4);
+    ASSERT_EQ(memory->readByte(0xC000), 6);
+
+    memory->writeByte(0x8000, 0x40);
+
+    ASSERT_EQ(memory->readByte(0x8000), 6);
+    ASSERT_EQ(memory->readByte(0xC000), 3);
+    ASSERT_EQ(memory->getReadOnlyPage(0xC000)[0], 3);
+}
+
+TEST(MMC3, Chr_banks_and_mirroring)
+{
+    auto memory = std::make_shared<PPUMemory>();
+    auto cpuMemory = std::make_shared<CPUMemory>(CPUMemory::Compact);
+    MMC3 mapper(createMMC3Rom());
+    mapper.setupCPU(cpuMemory);
+    mapper.setupPPU(memory);
+
+    cpuMemory->writeByte(0x8000, 0x00);
+    cpuMemory->writeByte(0x8001, 0x0A);
+    cpuMemory->writeByte(0x8000, 0x05);
+    cpuMemory->writeByte(0x8001, 0x0F);
+
+    ASSERT_EQ(memory->readByte(0x0000), 10);
+    ASSERT_EQ(memory->readByte(0x0400), 11);
+    ASSERT_EQ(memory->readByte(0x1C00), 15);
+
+    cpuMemory->writeByte(0x8000, 0x80);
+
+    ASSERT_EQ(memory->readByte(0x1000), 10);
+    ASSERT_EQ(memory->readByte(0x0C00), 15);
+
+    memory->writeByte(0x2000, 0x42);
+    ASSERT_EQ(memory->readByte(0x2800), 0x42);
+
+    cpuMemory->writeByte(0xA000, 0x01);
+    ASSERT_EQ(memory->readByte(0x2400), 0x42);
+    ASSERT_EQ(memory->readByte(0x3400), 0x42);
+}
+
+TEST(MMC3, Four_screen)
+{
+    auto memory = std::make_shared<PPUMemory>();
+    auto cpuMemory = std::make_shared<CPUMemory>(CPUMemory::Compact);
+    MMC3 mapper(createMMC3Rom(0, 0x49));
+    mapper.setupCPU(cpuMemory);
+    mapper.setupPPU(memory);
+
+    memory->writeByte(0x2000, 0x42);
+    cpuMemory->writeByte(0xA000, 0x01);
+
+    ASSERT_EQ(memory->readByte(0x2400), 0x00);
+    ASSERT_EQ(memory->readByte(0x2800), 0x00);
+    ASSERT_EQ(memory->readByte(0x3000), 0x42);
+}
+
+TEST(MMC3, Prg_ram_protect)
+{
+    auto memory = std::make_shared<CPUMemory>(CPUMemory::Compact);
+    MMC3 mapper(createMMC3Rom());
+    mapper.setupCPU(memory);
+
+    memory->writeByte(0x6000, 0x42);
+    memory->writeByte(0xA001, 0xC0);
+    memory->writeByte(0x6000, 0x24);
+
+    ASSERT_EQ(memory->readByte(0x6000), 0x42);
+
+    memory->writeByte(0xA001, 0x00);
+
+    ASSERT_EQ(memory->readByte(0x6000), 0x00);
+
+    memory->writeByte(0xA001, 0x80);
+
+    ASSERT_EQ(memory->readByte(0x6000), 0x42);
+}
+
+TEST(MMC3, Prg_ram_size)
+{
+    auto memory = std::make_shared<CPUMemory>(CPUMemory::Compact);
+    MMC3 mapper(createMMC3Rom(5));
+    mapper.setupCPU(memory);
+
+    memory->writeByte(0x6000, 0x42);
+    memory->writeByte(0x67FF, 0x24);
+
+    ASSERT_EQ(memory->readByte(0x6800), 0x42);
+    ASSERT_EQ(memory->readByte(0x7FFF), 0x24);
+
+    memory->writeByte(0xA001, 0x00);
+
+    ASSERT_EQ(memory->readByte(0x6000), 0x00);
+}
+
+TEST(MMC3, Counter_clocks)
+{
+    for (uint64_t clock = 0; clock < 1000; ++clock)
+    {
+        auto cycle = MMC3::getClockCycle(clock);
+
+        ASSERT_EQ(MMC3::getClockCount(cycle), clock + 1);
+        ASSERT_EQ(MMC3::getClockCount(cycle - 1), clock);
+    }
+}
+
+TEST(MMC3, Scanline_irq)
+{
+    CPU cpu(std::make_shared<CPUMemory>(CPUMemory::Compact));
+    auto mapper = std::make_shared<MMC3>(createMMC3Rom());
+    mapper->setupCPU(cpu.getMemory());
+    mapper->setupInterrupts(&cpu);
+    cpu.reset();
+
+    cpu.getMemory()->writeByte(0xC000, 10);
+    cpu.getMemory()->writeByte(0xC001, 0);
+    cpu.getMemory()->writeByte(0xE001, 0);
+    mapper->setRendering(true);
+
+    ASSERT_EQ(cpu.getScheduler()->getDeadline(Scheduler::MapperIrq), MMC3::getClockCycle(10));
+
+    // One IRQ every 11 scanlines: 21 of them fit into the 241 counter clocks of a frame
+    cpu.runFor(MMC3::getClockCycle(240) + 10);
+
+    ASSERT_EQ(cpu.getMemory()->readByte(0x10), 21);
+    ASSERT_EQ(cpu.getScheduler()->getDeadline(Scheduler::MapperIrq), MMC3::getClockCycle(241));
+
+    mapper->setRendering(false);
+
+    ASSERT_FALSE(cpu.getScheduler()->isScheduled(Scheduler::MapperIrq));
+}
+
+// 128 KiB of PRG ROM with every 16 KiB bank filled with its number and 16 KiB of CHR ROM with every 4 KiB bank
+// filled with its number
+static std::shared_ptr<INESRom> createMMC1Rom()
+{
+    std::string data = { 'N', 'E', 'S', 0x1A, 8, 2, 0x10, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    for (int bank = 0; bank < 8; ++bank)
+    {
+        data.append(MMC1::PRG_BANK_SIZE, static_cast<char>(bank));
+    }
+    for (int bank = 0; bank < 4; ++bank)
+    {
+        data.append(MMC1::CHR_BANK_SIZE, static_cast<char>(bank));
+    }
+
+    auto rom = std::make_shared<INESRom>();
+    std::istringstream stream(data);
+    rom->read(stream);
+    return rom;
+}
+
+static void writeSerial(Memory& memory, uint16_t address, uint8_t value)
+{
+    for (int i = 0; i < 5; ++i)
+    {
+        memory.writeByte(address, (value >> i) & 0x01);
+    }
+}
+
+TEST(MMC1, Prg_banks)
+{
+    auto memory = std::make_shared<CPUMemory>(CPUMemory::Compact);
+    MMC1 mapper(createMMC1Rom());
+    mapper.setupCPU(memory);
+
+    ASSERT_EQ(memory->readByte(0x8000), 0);
+    ASSERT_EQ(memory->readByte(0xC000), 7);
+
+    writeSerial(*memory, 0xE000, 0x03);
+
+    ASSERT_EQ(memory->readByte(0x8000), 3);
+    ASSERT_EQ(memory->readByte(0xC000), 7);
+
+    writeSerial(*memory, 0x8000, 0x08);
+
+    ASSERT_EQ(memory->readByte(0x8000), 0);
+    ASSERT_EQ(memory->readByte(0xC000), 3);
+
+    writeSerial(*memory, 0x8000, 0x00);
+
+    ASSERT_EQ(memory->readByte(0x8000), 2);
+    ASSERT_EQ(memory->readByte(0xC000), 3);
+}
+
+TEST(MMC1, Shift_register)
+{
+    auto memory = std::make_shared<CPUMemory>(CPUMemory::Compact);
+    MMC1 mapper(createMMC1Rom());
+    mapper.setupCPU(memory);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        memory->writeByte(0xE000, 0x01);
+    }
+
+    ASSERT_EQ(memory->readByte(0x8000), 0);
+
+    memory->writeByte(0xE000, 0x80);
+    writeSerial(*memory, 0xE000, 0x05);
+
+    ASSERT_EQ(memory->readByte(0x8000), 5);
+
+    memory->writeByte(0x6000, 0x42);
+
+    ASSERT_EQ(memory->readByte(0x6000), 0x42);
+}
+
+TEST(MMC1, Chr_banks_and_mirroring)
+{
+    auto memory = std::make_shared<PPUMemory>();
+    auto cpuMemory = std::make_shared<CPUMemory>(CPUMemory::Compact);
+    MMC1 mapper(createMMC1Rom());
+    mapper.setupCPU(cpuMemory);
+    mapper.setupPPU(memory);
+
+    writeSerial(*cpuMemory, 0xA000, 0x03);
+
+    ASSERT_EQ(memory->readByte(0x0000), 2);
+    ASSERT_EQ(memory->readByte(0x1000), 3);
+
+    writeSerial(*cpuMemory, 0x8000, 0x1C);
+    writeSerial(*cpuMemory, 0xC000, 0x00);
+
+    ASSERT_EQ(memory->readByte(0x0000), 3);
+    ASSERT_EQ(memory->readByte(0x1000), 0);
+
+    memory->writeByte(0x2000, 0x42);
+
+    ASSERT_EQ(memory->readByte(0x2C00), 0x42);
+}
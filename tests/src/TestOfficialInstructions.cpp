@@ -2340,4 +2340,129 @@ TEST(CPU, TYA_flag_Z_negative)
     cpu.tick();
 
     ASSERT_FALSE(registers.getFlag(CPU::Registers::Flags::Z));
-}
\ No newline at end of file
+}
+
+TEST(CPU, Table_dispatch)
+{
+    CPU cpu({ 0xA2, 0x03,
+              0xCA,
+              0xD0, 0xFD,
+              0x69, 0x05 });
+    auto& registers = cpu.getRegisters();
+    cpu.setDispatchMode(CPU::DispatchMode::Table);
+
+    cpu.tick(8);
+
+    ASSERT_EQ(registers.X, 0);
+    ASSERT_EQ(registers.A, 5);
+    ASSERT_FALSE(registers.getFlag(CPU::Registers::Flags::Z));
+}
+
+TEST(CPU, RunFor)
+{
+    CPU cpu({ 0xA2, 0x03,
+              0xCA,
+              0xD0, 0xFD,
+              0x69, 0x05 });
+    auto& registers = cpu.getRegisters();
+
+    auto overshoot = cpu.runFor(5);
+
+    ASSERT_EQ(cpu.getCycle(), 6);
+    ASSERT_EQ(overshoot, 1);
+    ASSERT_EQ(registers.X, 2);
+    ASSERT_EQ(registers.PC, CPUMemory::ROM_OFFSET + 2);
+}
+
+TEST(CPU, RunUntil_PC)
+{
+    CPU cpu({ 0xA2, 0x03,
+              0xCA,
+              0xD0, 0xFD,
+              0x69, 0x05 });
+    auto& registers = cpu.getRegisters();
+
+    cpu.runUntil([](const CPU& cpu) { return cpu.getRegisters().PC == CPUMemory::ROM_OFFSET + 5; });
+
+    ASSERT_EQ(registers.X, 0);
+    ASSERT_EQ(registers.A, 0);
+}
+
+
+TEST(CPU, Opcode_table)
+{
+    for (int opcode = 0; opcode < 0x100; ++opcode)
+    {
+        auto& info = CPU::OPCODES[opcode];
+        std::string mnemonic = info.mnemonic;
+        if (info.mode == CPU::Relative || mnemonic == "JMP" || mnemonic == "JSR" || mnemonic == "RTS" ||
+            mnemonic == "RTI" || mnemonic == "BRK" || mnemonic == "KIL")
+        {
+            continue;
+        }
+
+        CPU cpu({ static_cast<uint8_t>(opcode), 0x10, 0x00 });
+        cpu.tick();
+
+        ASSERT_EQ(cpu.getCycle(), info.cycles) << mnemonic << " " << opcode;
+        ASSERT_EQ(cpu.getRegisters().PC, 0x8000 + info.length) << mnemonic << " " << opcode;
+    }
+}
+
+TEST(CPU, Dispatch_modes_agree)
+{
+    auto run = [](CPU::DispatchMode mode, CPU& cpu)
+    {
+        auto memory = cpu.getMemory();
+        for (int address = 0; address < 0x200; ++address)
+        {
+            memory->writeByte(address, static_cast<uint8_t>(address * 7 + 3));
+        }
+        cpu.setDispatchMode(mode);
+        auto& registers = cpu.getRegisters();
+        registers.A = 0x5A;
+        registers.X = 0x03;
+        registers.Y = 0x07;
+        registers.P |= CPU::Registers::Flags::C;
+        cpu.tick();
+    };
+
+    for (int opcode = 0; opcode < 0x100; ++opcode)
+    {
+        CPU table({ static_cast<uint8_t>(opcode), 0x10, 0x00 });
+        CPU execute({ static_cast<uint8_t>(opcode), 0x10, 0x00 });
+        run(CPU::Table, table);
+        run(CPU::Switch, execute);
+
+        auto& expected = table.getRegisters();
+        auto& actual = execute.getRegisters();
+        ASSERT_EQ(table.getCycle(), execute.getCycle()) << opcode;
+        ASSERT_EQ(expected.A, actual.A) << opcode;
+        ASSERT_EQ(expected.X, actual.X) << opcode;
+        ASSERT_EQ(expected.Y, actual.Y) << opcode;
+        ASSERT_EQ(expected.P, actual.P) << opcode;
+        ASSERT_EQ(expected.S, actual.S) << opcode;
+        ASSERT_EQ(expected.PC, actual.PC) << opcode;
+        for (int address = 0; address < 0x10000; ++address)
+        {
+            ASSERT_EQ(table.getMemory()->readByte(address), execute.getMemory()->readByte(address)) << opcode;
+        }
+    }
+}
+
+TEST(CPU, Lazy_flags_PHP)
+{
+    CPU cpu({ 0xA9, 0x00,
+              0x08,
+              0xA9, 0x80 });
+    cpu.setLazyFlagsEnabled(true);
+
+    cpu.tick(3);
+    const CPU& reader = cpu;
+
+    ASSERT_TRUE(reader.getRegisters().getFlag(CPU::Registers::Flags::N));
+    ASSERT_FALSE(reader.getRegisters().getFlag(CPU::Registers::Flags::Z));
+    ASSERT_EQ(cpu.getMemory()->readByte(0x01FF) & CPU::Registers::Flags::Z, CPU::Registers::Flags::Z);
+    ASSERT_FALSE(cpu.getRegisters().getFlag(CPU::Registers::Flags::Z));
+    ASSERT_TRUE(cpu.getRegisters().getFlag(CPU::Registers::Flags::N));
+}
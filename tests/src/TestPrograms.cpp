@@ -3,7 +3,7 @@
 #include <rom/INESRom.h>
 #include <mappers/MapperFactory.h>
 #include <cpu/CPU.h>
-#include <Memory.h>
+#include <memory/Memory.h>
 #include "utils/TestProgram.h"
 
 using namespace nescore;
@@ -139,3 +139,63 @@ TEST(CPU, Special)
     out.flush();
     ASSERT_EQ(status, 0);
 }
+
+TEST(CPU, Block_cache)
+{
+    const char* files[] = {
+        "tests/data/cpu/01-implied.nes",
+        "tests/data/cpu/02-immediate.nes",
+        "tests/data/cpu/03-zero_page.nes",
+        "tests/data/cpu/04-zp_xy.nes",
+        "tests/data/cpu/05-absolute.nes",
+        "tests/data/cpu/06-abs_xy.nes",
+        "tests/data/cpu/07-ind_x.nes",
+        "tests/data/cpu/08-ind_y.nes",
+        "tests/data/cpu/09-branches.nes",
+        "tests/data/cpu/10-stack.nes",
+        "tests/data/cpu/11-special.nes"
+    };
+
+    for (auto file : files)
+    {
+        TestProgram test(file, true);
+
+        int status = test.run();
+
+        auto& out = status == 0 ? std::cout : std::cerr;
+        out << std::endl << test.getOutput() << std::endl;
+        out.flush();
+        ASSERT_EQ(status, 0) << file;
+    }
+}
+
+
+TEST(CPU, Lazy_flags)
+{
+    const char* files[] = {
+        "tests/data/cpu/01-implied.nes",
+        "tests/data/cpu/02-immediate.nes",
+        "tests/data/cpu/03-zero_page.nes",
+        "tests/data/cpu/04-zp_xy.nes",
+        "tests/data/cpu/05-absolute.nes",
+        "tests/data/cpu/06-abs_xy.nes",
+        "tests/data/cpu/07-ind_x.nes",
+        "tests/data/cpu/08-ind_y.nes",
+        "tests/data/cpu/09-branches.nes",
+        "tests/data/cpu/10-stack.nes",
+        "tests/data/cpu/11-special.nes"
+    };
+
+    for (auto file : files)
+    {
+        TestProgram test(file);
+        test.getCPU().setLazyFlagsEnabled(true);
+
+        int status = test.run();
+
+        auto& out = status == 0 ? std::cout : std::cerr;
+        out << std::endl << test.getOutput() << std::endl;
+        out.flush();
+        ASSERT_EQ(status, 0) << file;
+    }
+}
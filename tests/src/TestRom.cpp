@@ -1,6 +1,13 @@
 #include <gtest/gtest.h>
+#include <cstddef>
 #include <fstream>
+#include <sstream>
 #include <rom/INESRom.h>
+#include <rom/RomRegistry.h>
+#include <rom/RomIndex.h>
+#include <rom/Crc32.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace nescore;
 
@@ -20,4 +27,313 @@ TEST(ROM, Load)
     ASSERT_FALSE(rom.isNES2Format());
 }
 
-#undef READ_ROM
\ No newline at end of file
+#undef READ_ROM
+
+static std::string createRomImage()
+{
+    std::string data = { 'N', 'E', 'S', 0x1A, 2, 1, 0x01, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    data.append(INESRom::PRG_ROM_BANK_SIZE, 0x01);
+    data.append(INESRom::PRG_ROM_BANK_SIZE, 0x02);
+    data.append(INESRom::CHR_ROM_BANK_SIZE, 0x03);
+    return data;
+}
+
+TEST(ROM, Parse_buffer)
+{
+    auto data = createRomImage();
+    auto image = reinterpret_cast<const uint8_t*>(data.data());
+    INESRom rom;
+
+    rom.parse(image, data.size());
+
+    ASSERT_EQ(rom.getPrgRomBanks(), 2);
+    ASSERT_EQ(rom.getChrRomBanks(), 1);
+    ASSERT_EQ(rom.getMirroring(), INESRom::VERTICAL);
+    ASSERT_EQ(rom.getPrgRomBank(0)->getData(), image + INESRom::HEADER_SIZE);
+    ASSERT_EQ(rom.getPrgRomBank(1)->readByte(0), 0x02);
+    ASSERT_EQ(rom.getChrRomBank(0)->readByte(0), 0x03);
+    ASSERT_ANY_THROW(rom.parse(image, data.size() - 1));
+    ASSERT_ANY_THROW(rom.parse(image, INESRom::HEADER_SIZE - 1));
+}
+
+TEST(ROM, Load_from_file)
+{
+    auto data = createRomImage();
+    auto fileName = testing::TempDir() + "load_from_file.nes";
+    {
+        std::ofstream file(fileName, std::ios::binary);
+        file << data;
+    }
+    INESRom rom;
+
+    rom.load(fileName);
+    std::remove(fileName.c_str());
+
+    ASSERT_EQ(rom.getPrgRomBanks(), 2);
+    ASSERT_EQ(rom.getPrgRomBank(0)->readByte(0x3FFF), 0x01);
+    ASSERT_EQ(rom.getChrRomBank(0)->readByte(0x1FFF), 0x03);
+    ASSERT_ANY_THROW(rom.load(fileName));
+}
+
+TEST(ROM, Registry_shares_equal_roms)
+{
+    auto data = createRomImage();
+    auto other = createRomImage();
+    other[INESRom::HEADER_SIZE] = 0x42;
+    auto load = [](const std::string& image)
+    {
+        auto rom = std::make_shared<INESRom>();
+        rom->parse(reinterpret_cast<const uint8_t*>(image.data()), image.size());
+        return RomRegistry::getInstance().add(rom);
+    };
+    auto size = RomRegistry::getInstance().getSize();
+
+    auto first = load(data);
+    auto second = load(data);
+    auto third = load(other);
+
+    ASSERT_EQ(first, second);
+    ASSERT_NE(first, third);
+    ASSERT_EQ(RomRegistry::getInstance().getSize(), size + 2);
+
+    first.reset();
+    second.reset();
+
+    ASSERT_EQ(RomRegistry::getInstance().getSize(), size + 1);
+
+    static_assert(std::is_same<decltype(first), std::shared_ptr<const INESRom>>::value,
+                  "Shared ROMs must not be writable");
+    first = load(data);
+
+    ASSERT_EQ(RomRegistry::getInstance().getSize(), size + 2);
+}
+
+TEST(ROM, Banks_share_one_arena)
+{
+    std::istringstream stream(createRomImage());
+    INESRom rom;
+
+    rom.read(stream);
+
+    auto data = rom.getData();
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(data) % INESRom::DATA_ALIGNMENT, 0);
+    ASSERT_EQ(rom.getDataSize(), 2 * INESRom::PRG_ROM_BANK_SIZE + INESRom::CHR_ROM_BANK_SIZE);
+    ASSERT_EQ(rom.getPrgRomBank(0)->getData(), data);
+    ASSERT_EQ(rom.getPrgRomBank(1)->getData(), data + INESRom::PRG_ROM_BANK_SIZE);
+    ASSERT_EQ(rom.getChrRomBank(0)->getData(), data + 2 * INESRom::PRG_ROM_BANK_SIZE);
+    ASSERT_EQ(rom.getChrRomBank(0)->readByte(0), 0x03);
+}
+
+TEST(ROM, Parse_header)
+{
+    auto data = createRomImage();
+    data[7] = 0x10;
+    data[12] = 'D';
+    auto image = reinterpret_cast<const uint8_t*>(data.data());
+    INESRom rom;
+
+    rom.parse(image, data.size());
+
+    ASSERT_EQ(rom.getMapper(), 0);
+
+    data[12] = 0;
+    rom.parse(image, data.size());
+
+    ASSERT_EQ(rom.getMapper(), 0x10);
+
+    data[4] = 0;
+
+    ASSERT_ANY_THROW(rom.parse(image, data.size()));
+}
+
+TEST(ROM, Parse_header_keeps_console_flags)
+{
+    auto data = createRomImage();
+    data[7] = 0x13;
+    data[12] = 'D';
+    data.append(INESRom::PLAY_CHOICE_10_SIZE, 0x04);
+    INESRom rom;
+
+    rom.parse(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+
+    ASSERT_EQ(rom.getMapper(), 0);
+    ASSERT_TRUE(rom.hasVSUnisystem());
+    ASSERT_TRUE(rom.hasPlayChoice10());
+}
+
+TEST(ROM, NES2_header)
+{
+    auto data = createRomImage();
+    auto image = reinterpret_cast<const uint8_t*>(data.data());
+    INESRom rom;
+
+    data[6] = 0x02;
+    rom.parse(image, data.size());
+
+    ASSERT_EQ(rom.getPrgRamSize(), 0);
+    ASSERT_EQ(rom.getPrgNvramSize(), INESRom::PRG_RAM_BANK_SIZE);
+    ASSERT_EQ(rom.getChrRamSize(), 0);
+    ASSERT_EQ(rom.getSubmapper(), 0);
+
+    data[6] = 0x40;
+    data[7] = 0x18;
+    data[8] = 0x51;
+    data[10] = 0x70;
+    data[11] = 0x09;
+    data[12] = 0x03;
+    rom.parse(image, data.size());
+
+    ASSERT_TRUE(rom.isNES2Format());
+    ASSERT_EQ(rom.getMapper(), 0x114);
+    ASSERT_EQ(rom.getSubmapper(), 5);
+    ASSERT_EQ(rom.getPrgRamSize(), 0);
+    ASSERT_EQ(rom.getPrgNvramSize(), 0x2000);
+    ASSERT_EQ(rom.getChrRamSize(), 0x8000);
+    ASSERT_EQ(rom.getChrNvramSize(), 0);
+    ASSERT_EQ(rom.getTVSystem(), INESRom::DENDY);
+
+    data[9] = 0x10;
+    data.append(0x100 * INESRom::CHR_ROM_BANK_SIZE, 0x04);
+    image = reinterpret_cast<const uint8_t*>(data.data());
+    rom.parse(image, data.size());
+
+    ASSERT_EQ(rom.getChrRomBanks(), 0x101);
+    ASSERT_EQ(rom.getChrRomBank(0x100)->readByte(0), 0x04);
+
+    data[9] = 0x0F;
+
+    ASSERT_ANY_THROW(rom.parse(image, data.size()));
+}
+
+TEST(ROM, Read_truncated_stream)
+{
+    auto data = createRomImage();
+    std::istringstream stream(data.substr(0, data.size() - 1));
+    INESRom rom;
+
+    ASSERT_ANY_THROW(rom.read(stream));
+    ASSERT_EQ(rom.getData(), nullptr);
+}
+
+TEST(ROM, Crc32)
+{
+    std::string data = "123456789";
+
+    ASSERT_EQ(Crc32::compute(reinterpret_cast<const uint8_t*>(data.data()), data.size()), 0xCBF43926);
+    ASSERT_EQ(Crc32::compute(nullptr, 0), 0);
+}
+
+TEST(ROM, Crc32_matches_portable)
+{
+    std::vector<uint8_t> data(0x10000 + 100);
+    uint32_t seed = 1;
+    for (auto& value : data)
+    {
+        seed = seed * 1103515245 + 12345;
+        value = seed >> 16;
+    }
+
+    for (size_t size : { 0, 7, 63, 64, 65, 100, 127, 128, 1000, 0x4000, 0x10000 + 100 })
+    {
+        for (size_t offset : { 0, 3 })
+        {
+            size_t length = std::min(size, data.size() - offset);
+            ASSERT_EQ(Crc32::compute(data.data() + offset, length, 0x12345678),
+                      Crc32::computePortable(data.data() + offset, length, 0x12345678));
+        }
+    }
+
+    auto whole = Crc32::compute(data.data(), data.size());
+    ASSERT_EQ(Crc32::compute(data.data() + 1000, data.size() - 1000, Crc32::compute(data.data(), 1000)), whole);
+}
+
+TEST(ROM, Bank_hashes)
+{
+    auto data = createRomImage();
+    auto image = reinterpret_cast<const uint8_t*>(data.data());
+    INESRom rom;
+
+    rom.parse(image, data.size());
+
+    auto prg = image + INESRom::HEADER_SIZE;
+    ASSERT_EQ(rom.getPrgHash(), Crc32::compute(prg, 2 * INESRom::PRG_ROM_BANK_SIZE));
+    ASSERT_EQ(rom.getChrHash(), Crc32::compute(prg + 2 * INESRom::PRG_ROM_BANK_SIZE, INESRom::CHR_ROM_BANK_SIZE));
+
+    data[5] = 0;
+    data.resize(INESRom::HEADER_SIZE + 2 * INESRom::PRG_ROM_BANK_SIZE);
+    data[INESRom::HEADER_SIZE] = 0x42;
+    image = reinterpret_cast<const uint8_t*>(data.data());
+    rom.parse(image, data.size());
+
+    ASSERT_EQ(rom.getPrgHash(), Crc32::compute(image + INESRom::HEADER_SIZE, 2 * INESRom::PRG_ROM_BANK_SIZE));
+    ASSERT_EQ(rom.getChrHash(), 0);
+}
+
+TEST(ROM, Index_directory)
+{
+    auto directory = testing::TempDir() + "rom_index";
+    auto indexName = testing::TempDir() + "rom_index.bin";
+    mkdir(directory.c_str(), 0755);
+    mkdir((directory + "/sub").c_str(), 0755);
+    auto chrRam = createRomImage();
+    chrRam[5] = 0;
+    chrRam[6] = 0x42;
+    chrRam.resize(INESRom::HEADER_SIZE + 2 * INESRom::PRG_ROM_BANK_SIZE);
+    std::vector<std::pair<std::string, std::string>> files = {
+        { directory + "/a.nes", createRomImage() },
+        { directory + "/sub/b.NES", chrRam },
+        { directory + "/sub/broken.nes", "NES" },
+        { directory + "/readme.txt", createRomImage() }
+    };
+    for (auto& file : files)
+    {
+        std::ofstream(file.first, std::ios::binary) << file.second;
+    }
+    ASSERT_EQ(symlink(directory.c_str(), (directory + "/sub/loop").c_str()), 0);
+
+    RomIndex index;
+    index.scan(directory, 2);
+    index.save(indexName);
+    RomIndex mapped;
+    mapped.open(indexName);
+
+    for (auto& file : files)
+    {
+        std::remove(file.first.c_str());
+    }
+    unlink((directory + "/sub/loop").c_str());
+    rmdir((directory + "/sub").c_str());
+    rmdir(directory.c_str());
+
+    ASSERT_EQ(index.getSize(), 2);
+    ASSERT_EQ(mapped.getSize(), 2);
+    ASSERT_EQ(mapped.getPath(0), files[0].first);
+    ASSERT_EQ(mapped.getPath(1), files[1].first);
+
+    auto& first = mapped.getEntry(0);
+    auto prg = files[0].second.substr(INESRom::HEADER_SIZE, 2 * INESRom::PRG_ROM_BANK_SIZE);
+    ASSERT_EQ(first.prgCrc, Crc32::compute(reinterpret_cast<const uint8_t*>(prg.data()), prg.size()));
+    ASSERT_EQ(first.prgCrc, index.getEntry(0).prgCrc);
+    ASSERT_EQ(first.prgRomBanks, 2);
+    ASSERT_EQ(first.chrRomBanks, 1);
+    ASSERT_EQ(first.flags, RomIndex::VERTICAL_MIRRORING);
+    ASSERT_FALSE(first.hasChrRam());
+
+    auto& second = mapped.getEntry(1);
+    ASSERT_EQ(second.mapper, 4);
+    ASSERT_EQ(second.chrCrc, 0);
+    ASSERT_EQ(second.flags, RomIndex::BATTERY);
+    ASSERT_TRUE(second.hasChrRam());
+
+    std::fstream corrupt(indexName, std::ios::binary | std::ios::in | std::ios::out);
+    uint32_t pathOffset = 0x10000;
+    corrupt.seekp(sizeof(RomIndex::FileHeader) + sizeof(RomIndex::Entry) + offsetof(RomIndex::Entry, pathOffset));
+    corrupt.write(reinterpret_cast<const char*>(&pathOffset), sizeof(pathOffset));
+    corrupt.close();
+    ASSERT_ANY_THROW(mapped.open(indexName));
+
+    std::ofstream(indexName, std::ios::binary) << "NESX";
+    ASSERT_ANY_THROW(mapped.open(indexName));
+    std::remove(indexName.c_str());
+    ASSERT_EQ(mapped.getSize(), 0);
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <cpu/CPU.h>
+#include <cpu/CPUMemory.h>
+#include <scheduler/Scheduler.h>
+
+using namespace nescore;
+
+TEST(Scheduler, Next_deadline)
+{
+    Scheduler scheduler;
+
+    scheduler.schedule(Scheduler::Irq, 100);
+    scheduler.schedule(Scheduler::Nmi, 50);
+
+    ASSERT_EQ(scheduler.getNextDeadline(), 50);
+
+    scheduler.cancel(Scheduler::Nmi);
+
+    ASSERT_EQ(scheduler.getNextDeadline(), 100);
+    ASSERT_FALSE(scheduler.isScheduled(Scheduler::Nmi));
+}
+
+TEST(Scheduler, Run_next)
+{
+    Scheduler scheduler;
+    cpu_cycle_t fired = 0;
+    scheduler.setHandler(Scheduler::Irq, [&fired](cpu_cycle_t deadline) { fired = deadline; });
+
+    scheduler.schedule(Scheduler::Irq, 20);
+    scheduler.runNext();
+
+    ASSERT_EQ(fired, 20);
+    ASSERT_EQ(scheduler.getNextDeadline(), Scheduler::NEVER);
+}
+
+TEST(Scheduler, DMA_skips_cycles)
+{
+    CPU cpu({ 0xEA,
+              0xEA });
+
+    cpu.tick();
+    cpu.startDmaTransfer();
+    cpu.tick();
+
+    ASSERT_EQ(cpu.getCycle(), 2 + 513 + 2);
+    ASSERT_EQ(cpu.getRegisters().PC, CPUMemory::ROM_OFFSET + 2);
+}
+
+TEST(Scheduler, NMI)
+{
+    CPU cpu({ 0xEA });
+    auto memory = cpu.getMemory();
+    memory->writeShort(CPUMemory::NMI_VECTOR, 0x9000);
+    memory->writeByte(0x9000, 0xE8);
+
+    cpu.nmi();
+    cpu.tick();
+
+    auto& registers = cpu.getRegisters();
+    ASSERT_EQ(registers.PC, 0x9001);
+    ASSERT_EQ(registers.X, 1);
+    ASSERT_EQ(registers.S, 0xFC);
+    ASSERT_EQ(memory->readShort(0x01FE), 0x8000);
+}
+
+TEST(Scheduler, IRQ_masked)
+{
+    CPU cpu({ 0xEA,
+              0x58,
+              0xEA });
+    auto memory = cpu.getMemory();
+    memory->writeShort(CPUMemory::IRQ_VECTOR, 0x9000);
+    memory->writeByte(0x9000, 0xEA);
+
+    cpu.setIrq(true);
+    cpu.tick(2);
+
+    ASSERT_EQ(cpu.getRegisters().PC, CPUMemory::ROM_OFFSET + 2);
+
+    cpu.tick();
+
+    ASSERT_EQ(cpu.getRegisters().PC, 0x9001);
+}
+
+TEST(Scheduler, Idle_loop_skip)
+{
+    CPU interpreted({ 0xA5, 0x10,
+                      0xF0, 0xFC,
+                      0x02 });
+    CPU skipped({ 0xA5, 0x10,
+                  0xF0, 0xFC,
+                  0x02 });
+    skipped.setIdleLoopSkipEnabled(true);
+
+    for (auto cpu : { &interpreted, &skipped })
+    {
+        auto memory = cpu->getMemory();
+        memory->writeShort(CPUMemory::NMI_VECTOR, 0x9000);
+        memory->writeByte(0x9000, 0xE6);
+        memory->writeByte(0x9001, 0x10);
+        memory->writeByte(0x9002, 0x40);
+        cpu->getScheduler()->schedule(Scheduler::Nmi, 10001);
+
+        cpu->runFor(20000);
+    }
+
+    ASSERT_EQ(skipped.getCycle(), interpreted.getCycle());
+    ASSERT_EQ(skipped.getRegisters().PC, interpreted.getRegisters().PC);
+    ASSERT_EQ(skipped.getRegisters().A, 0x01);
+    ASSERT_EQ(skipped.getMemory()->readByte(0x10), 0x01);
+}
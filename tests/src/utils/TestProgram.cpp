@@ -1,42 +1,57 @@
-#include <fstream>
 #include <cpu/CPU.h>
 #include <cpu/CPUMemory.h>
 #include <rom/INESRom.h>
+#include <rom/RomRegistry.h>
 #include "TestProgram.h"
 
 using namespace nescore;
 
-TestProgram::TestProgram(const std::string &fileName)
-    : _cpu(new CPU())
+TestProgram::TestProgram(const std::string &fileName, bool blockCache)
+    : _cpu(new CPU(std::make_shared<CPUMemory>(CPUMemory::Compact)))
     , _rom(nullptr)
     , _mapper(nullptr)
+    , _status(0)
     , _started(false)
+    , _finished(false)
+    , _blockCache(blockCache)
 {
     loadRom(fileName);
+    _cpu->setBlockCacheEnabled(blockCache);
+
+    // The test ROMs write $80 to $6000 while running and the result code once they are done
+    _cpu->getMemory()->addHook(Memory::Range(0x6000, 0x6000), [this](uint16_t, uint8_t value, uint64_t) {
+        if (!_started)
+        {
+            _started = value == 0x80;
+            return;
+        }
+        if (value != 0x80)
+        {
+            _status = value;
+            _finished = true;
+            _cpu->stop();
+        }
+    });
 }
 
 int TestProgram::run()
 {
-    // Set PPU status
-    _cpu->getMemory()->writeByte(0x2002, 0b10000000);
     _cpu->reset();
 
-    while (true)
+    while (!_finished)
     {
-        _cpu->tick();
-
-        auto status = _cpu->getMemory()->readByte(0x6000);
-        if (!_started)
+        if (_blockCache)
         {
-            _started = status == 0x80;
-            continue;
+            _cpu->runFor(1000);
         }
-        if (status != 0x80)
+        else
         {
-            _output = _cpu->getMemory()->readString(0x6004);
-            return status;
+            _cpu->tick();
         }
     }
+
+    _output = _cpu->getMemory()->readString(0x6004);
+    return _status;
 }
 
 const std::string &TestProgram::getOutput() const
@@ -44,14 +59,16 @@ const std::string &TestProgram::getOutput() const
     return _output;
 }
 
-void TestProgram::loadRom(const std::string &fileName)
+CPU &TestProgram::getCPU()
 {
-    _rom = std::make_shared<INESRom>();
+    return *_cpu;
+}
 
-    std::ifstream fin;
-    fin.open(fileName, std::ios::binary);
-    _rom->read(fin);
+void TestProgram::loadRom(const std::string &fileName)
+{
+    _rom = RomRegistry::getInstance().load(fileName);
 
     _mapper = _mapperFactory.createMapper(_rom);
     _mapper->setupCPU(_cpu->getMemory());
+    _mapper->setupInterrupts(_cpu.get());
 }
\ No newline at end of file
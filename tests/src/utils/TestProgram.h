@@ -2,6 +2,7 @@
 #define NESCORE_TESTPROGRAM_H
 
 #include <string>
+#include <vector>
 #include <mappers/MapperFactory.h>
 
 namespace nescore
@@ -19,21 +20,25 @@ using namespace nescore;
 class TestProgram
 {
 public:
-    TestProgram(const std::string& fileName);
+    TestProgram(const std::string& fileName, bool blockCache = false);
 
     int run();
     const std::string& getOutput() const;
+    CPU& getCPU();
 
 private:
     void loadRom(const std::string& fileName);
 
 private:
     std::shared_ptr<CPU> _cpu;
-    std::shared_ptr<INESRom> _rom;
+    std::shared_ptr<const INESRom> _rom;
     std::shared_ptr<IRomMapper> _mapper;
     std::string _output;
     MapperFactory _mapperFactory;
+    int _status;
     bool _started;
+    bool _finished;
+    bool _blockCache;
 };
 
 
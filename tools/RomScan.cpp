@@ -0,0 +1,116 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <rom/INESRom.h>
+#include <rom/RomIndex.h>
+
+using namespace nescore;
+
+static int usage()
+{
+    std::cerr << "usage: romscan scan <directory> <index> [threads]" << std::endl
+              << "       romscan query <index> [--mapper <number>] [--chr-ram] [--battery] [--nes2]" << std::endl;
+    return 1;
+}
+
+static int scan(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        return usage();
+    }
+
+    RomIndex index;
+    index.scan(argv[2], argc > 4 ? std::atoi(argv[4]) : 0);
+    index.save(argv[3]);
+    std::cout << index.getSize() << " ROMs indexed" << std::endl;
+    return 0;
+}
+
+static int query(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        return usage();
+    }
+
+    int mapper = -1;
+    uint8_t flags = 0;
+    bool chrRam = false;
+    for (int i = 3; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--mapper") && i + 1 < argc)
+        {
+            mapper = std::atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--chr-ram"))
+        {
+            chrRam = true;
+        }
+        else if (!strcmp(argv[i], "--battery"))
+        {
+            flags |= RomIndex::BATTERY;
+        }
+        else if (!strcmp(argv[i], "--nes2"))
+        {
+            flags |= RomIndex::NES2_FORMAT;
+        }
+        else
+        {
+            return usage();
+        }
+    }
+
+    RomIndex index;
+    index.open(argv[2]);
+    for (uint32_t i = 0; i < index.getSize(); ++i)
+    {
+        auto& entry = index.getEntry(i);
+        if ((mapper >= 0 && entry.mapper != mapper) || (chrRam && !entry.hasChrRam()) || (entry.flags & flags) != flags)
+        {
+            continue;
+        }
+
+        std::cout << index.getPath(i) << "\tmapper " << entry.mapper << "." << int(entry.submapper)
+                  << "\tPRG " << entry.prgRomBanks * 16 << "K\tCHR " << entry.chrRomBanks * 8 << "K" << std::endl;
+    }
+
+    return 0;
+}
+
+static int run(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        return usage();
+    }
+    if (!strcmp(argv[1], "scan"))
+    {
+        return scan(argc, argv);
+    }
+    if (!strcmp(argv[1], "query"))
+    {
+        return query(argc, argv);
+    }
+
+    return usage();
+}
+
+int main(int argc, char** argv)
+{
+    // nesformat_error does not expose what(), so it is caught by name
+    try
+    {
+        return run(argc, argv);
+    }
+    catch (const nesformat_error&)
+    {
+        std::cerr << "romscan: unable to read or write the index" << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "romscan: " << e.what() << std::endl;
+    }
+
+    return 1;
+}